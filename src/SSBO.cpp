@@ -1,6 +1,7 @@
 #include "myglheaders.h"
 #include "SSBO.h"
 #include "debugmacro.h"
+#include <cstring>
 
 void SSBO::init(void* ptr, size_t bytes, unsigned binding){
     glGenBuffers(1, &id);
@@ -15,6 +16,14 @@ void SSBO::init(void* ptr, size_t bytes, unsigned binding){
     MYGLERRORMACRO
 }
 SSBO::~SSBO(){
+    for(int i = 0; i < SSBO_FRAMES; ++i){
+        if(fences[i])
+            glDeleteSync((GLsync)fences[i]);
+    }
+    if(mapped){
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+    }
     if(id){
         glDeleteBuffers(1, &id);
         MYGLERRORMACRO
@@ -26,3 +35,88 @@ void SSBO::upload(void* ptr, size_t bytes){
     glBufferData(GL_SHADER_STORAGE_BUFFER, bytes, ptr, GL_DYNAMIC_COPY);
     MYGLERRORMACRO
 }
+void SSBO::update(void* ptr, size_t bytes, size_t offset){
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+    MYGLERRORMACRO
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, bytes, ptr);
+    MYGLERRORMACRO
+}
+void SSBO::read(void* ptr, size_t bytes, size_t offset){
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+    MYGLERRORMACRO
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, offset, bytes, ptr);
+    MYGLERRORMACRO
+}
+void SSBO::bind(unsigned bind){
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, bind, id);
+    MYGLERRORMACRO
+}
+
+void SSBO::initMapped(size_t bytes, unsigned bind){
+    binding = bind;
+    GLint align = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &align);
+    alignment = align > 0 ? size_t(align) : 256;
+    allocate(bytes);
+}
+
+void SSBO::allocate(size_t bytes){
+    if(mapped){
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+        glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+        mapped = nullptr;
+    }
+    // frames in flight keep reading the old storage until they finish
+    if(id)
+        glDeleteBuffers(1, &id);
+    region_bytes = ((bytes + alignment - 1) / alignment) * alignment;
+    const size_t total = region_bytes * SSBO_FRAMES;
+    glGenBuffers(1, &id);
+    MYGLERRORMACRO
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+    MYGLERRORMACRO
+    if(GLEW_ARB_buffer_storage){
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_SHADER_STORAGE_BUFFER, total, nullptr, flags);
+        MYGLERRORMACRO
+        mapped = (unsigned char*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, total, flags);
+        MYGLERRORMACRO
+    }
+    else{
+        glBufferData(GL_SHADER_STORAGE_BUFFER, total, nullptr, GL_DYNAMIC_DRAW);
+        MYGLERRORMACRO
+    }
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, id, region * region_bytes, region_bytes);
+    MYGLERRORMACRO
+}
+
+bool SSBO::nextFrame(size_t bytes){
+    // everything submitted so far includes the readers of the current region
+    if(fences[region])
+        glDeleteSync((GLsync)fences[region]);
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % SSBO_FRAMES;
+    if(fences[region]){
+        glClientWaitSync((GLsync)fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync((GLsync)fences[region]);
+        fences[region] = nullptr;
+    }
+    if(bytes > region_bytes){
+        allocate(bytes > 2 * region_bytes ? bytes : 2 * region_bytes);
+        return true;
+    }
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, id, region * region_bytes, region_bytes);
+    MYGLERRORMACRO
+    return false;
+}
+
+void SSBO::write(const void* src, size_t bytes, size_t offset){
+    if(mapped){
+        memcpy(mapped + region * region_bytes + offset, src, bytes);
+        return;
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+    MYGLERRORMACRO
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, region * region_bytes + offset, bytes, src);
+    MYGLERRORMACRO
+}
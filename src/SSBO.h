@@ -1,13 +1,45 @@
 #ifndef SSBO_H
 #define SSBO_H
 
+#include <cstddef>
+
+// regions of a mapped SSBO, one written per frame while the others may
+// still be read by frames in flight
+#define SSBO_FRAMES 3
+
 class SSBO{
-    unsigned id;
+    unsigned id, binding;
+    // mapped storage, see initMapped
+    unsigned char* mapped;
+    size_t region_bytes, alignment;
+    int region;
+    void* fences[SSBO_FRAMES];
+    void allocate(size_t bytes);
 public:
-    SSBO() : id(0) {};
+    SSBO() : id(0), binding(0), mapped(nullptr), region_bytes(0), alignment(0), region(0) {
+        for(int i = 0; i < SSBO_FRAMES; ++i)
+            fences[i] = nullptr;
+    };
     void init(void* ptr, size_t bytes, unsigned binding=0);
     ~SSBO();
     void upload(void* src, size_t bytes);
+    void update(void* src, size_t bytes, size_t offset=0);
+    void read(void* dst, size_t bytes, size_t offset=0);
+    void bind(unsigned binding);
+    inline unsigned handle()const{ return id; }
+
+    /*
+        Immutable storage for SSBO_FRAMES regions of at least bytes each,
+        persistently and coherently mapped. Each frame, nextFrame() moves to
+        the next region once the gpu has finished the frame that last used
+        it, binds it and write() fills what changed in it. Falls back to
+        glBufferSubData without ARB_buffer_storage.
+    */
+    void initMapped(size_t bytes, unsigned binding);
+    // true when storage grew to fit bytes, leaving every region undefined
+    bool nextFrame(size_t bytes);
+    void write(const void* src, size_t bytes, size_t offset);
+    inline int currentRegion()const{ return region; }
 };
 
 #endif
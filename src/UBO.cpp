@@ -1,18 +1,65 @@
 #include "myglheaders.h"
 #include "UBO.h"
 #include "debugmacro.h"
+#include <cstring>
 
 
-UBO::UBO(void* ptr, size_t size, unsigned binding){
+UBO::UBO(void* ptr, size_t size, unsigned bind) : binding(bind), mapped(nullptr), slot(0){
+    GLint align = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+    align = align > 0 ? align : 256;
+    slot_bytes = ((size + align - 1) / align) * align;
+    for(int i = 0; i < UBO_SLOTS; ++i){
+        fences[i] = nullptr;
+    }
     glGenBuffers(1, &id);MYGLERRORMACRO
     glBindBuffer(GL_UNIFORM_BUFFER, id);MYGLERRORMACRO
-    glBufferData(GL_UNIFORM_BUFFER, size, ptr, GL_STATIC_DRAW);MYGLERRORMACRO
-    glBindBufferBase(GL_UNIFORM_BUFFER, binding, id);MYGLERRORMACRO
+    if(GLEW_ARB_buffer_storage){
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_UNIFORM_BUFFER, slot_bytes * UBO_SLOTS, nullptr, flags);MYGLERRORMACRO
+        mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, slot_bytes * UBO_SLOTS, flags);MYGLERRORMACRO
+    }
+    else{
+        glBufferData(GL_UNIFORM_BUFFER, slot_bytes * UBO_SLOTS, nullptr, GL_DYNAMIC_DRAW);MYGLERRORMACRO
+    }
+    if(ptr){
+        // the first upload moves on to slot 0
+        slot = UBO_SLOTS - 1;
+        upload(ptr, size);
+    }
+    else{
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, id, 0, slot_bytes);MYGLERRORMACRO
+    }
 }
 UBO::~UBO(){
+    for(int i = 0; i < UBO_SLOTS; ++i){
+        if(fences[i])
+            glDeleteSync((GLsync)fences[i]);
+    }
+    if(mapped){
+        glBindBuffer(GL_UNIFORM_BUFFER, id);
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    }
     glDeleteBuffers(1, &id);MYGLERRORMACRO
 }
 void UBO::upload(void* ptr, size_t size){
-    glBindBuffer(GL_UNIFORM_BUFFER, id);MYGLERRORMACRO
-    glBufferData(GL_UNIFORM_BUFFER, size, ptr, GL_STATIC_DRAW);MYGLERRORMACRO
+    // everything submitted so far includes the readers of the current slot
+    if(fences[slot])
+        glDeleteSync((GLsync)fences[slot]);
+    fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot = (slot + 1) % UBO_SLOTS;
+    if(fences[slot]){
+        glClientWaitSync((GLsync)fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync((GLsync)fences[slot]);
+        fences[slot] = nullptr;
+    }
+    size = size < slot_bytes ? size : slot_bytes;
+    if(mapped){
+        memcpy(mapped + slot * slot_bytes, ptr, size);
+    }
+    else{
+        glBindBuffer(GL_UNIFORM_BUFFER, id);MYGLERRORMACRO
+        glBufferSubData(GL_UNIFORM_BUFFER, slot * slot_bytes, size, ptr);MYGLERRORMACRO
+    }
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, id, slot * slot_bytes, slot_bytes);MYGLERRORMACRO
 }
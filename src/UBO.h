@@ -1,8 +1,24 @@
 #ifndef UBO_H
 #define UBO_H
 
+#include <cstddef>
+
+// slots of the ring, so frames in flight keep their own copy
+#define UBO_SLOTS 3
+
+/*
+    Uniform block in a ring of UBO_SLOTS aligned slots of one persistently
+    mapped buffer. Each upload moves to the next slot once the gpu has
+    finished with it, copies into the mapping and binds the slot with
+    glBindBufferRange, without any driver allocation. One UBO per block,
+    so per-pass parameters get their own ring and binding.
+*/
 class UBO{
-    unsigned id;
+    unsigned id, binding;
+    unsigned char* mapped;
+    size_t slot_bytes;
+    int slot;
+    void* fences[UBO_SLOTS];
 public:
     UBO(void* ptr, size_t size, unsigned binding);
     ~UBO();
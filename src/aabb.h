@@ -0,0 +1,40 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include "glm/glm.hpp"
+
+struct AABB{
+    glm::vec3 lo, hi;
+    AABB() : lo(100000.0f), hi(-100000.0f){}
+    AABB(const glm::vec3& a, const glm::vec3& b) : lo(a), hi(b){}
+    inline bool empty()const{
+        return lo.x > hi.x || lo.y > hi.y || lo.z > hi.z;
+    }
+    inline glm::vec3 center()const{
+        return (lo + hi) * 0.5f;
+    }
+    inline glm::vec3 extent()const{
+        return (hi - lo) * 0.5f;
+    }
+    inline void grow(const glm::vec3& p){
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    inline void grow(const AABB& b){
+        lo = glm::min(lo, b.lo);
+        hi = glm::max(hi, b.hi);
+    }
+    inline AABB expanded(float r)const{
+        return AABB(lo - glm::vec3(r), hi + glm::vec3(r));
+    }
+    inline bool overlaps(const AABB& b)const{
+        return lo.x <= b.hi.x && hi.x >= b.lo.x &&
+               lo.y <= b.hi.y && hi.y >= b.lo.y &&
+               lo.z <= b.hi.z && hi.z >= b.lo.z;
+    }
+    inline float distance(const glm::vec3& p)const{
+        return glm::length(glm::max(glm::max(lo - p, p - hi), glm::vec3(0.0f)));
+    }
+};
+
+#endif
@@ -0,0 +1,104 @@
+// Accumulation of one sample per pixel into the history of reprojection.h,
+// shared by depth.glsl and the wavefront kernels. Needs CAM_BUF.
+
+#include "octahedral.glsl"
+
+layout(binding = 0, rgba32f) uniform image2D color;
+
+// accumulation history, see reprojection.h
+uniform int reproject;
+uniform int history;
+uniform mat4 prev_VP;
+uniform vec3 prev_eye;
+layout(binding = 5, rgba32f) uniform readonly image2D prev_color;
+layout(binding = 6, rgba32f) uniform writeonly image2D hits;
+layout(binding = 7, rgba32f) uniform readonly image2D prev_hits;
+// pixels x0 y0 x1 y1 inclusive whose history an edit dropped
+uniform vec4 reset_rect;
+
+// with pixel_list set, one thread per pixel selected by adaptive.glsl
+// instead of one per pixel of the image
+uniform int pixel_list;
+layout(std430, binding = 9) readonly buffer PIXEL_LIST_BUF
+{
+    uint list_groups_x;
+    uint list_groups_y;
+    uint list_groups_z;
+    uint list_count;
+    uint list_pixels[];
+};
+
+// first hit albedo and object id for denoise.glsl
+uniform int gbuffer_enabled;
+layout(std430, binding = 10) writeonly buffer GBUFFER_BUF
+{
+    uvec2 gbuffer[]; // albedo as unorm4x8, object id
+};
+
+// the pixel of this invocation, false past the edge of the image or the list
+bool invocation_pixel(out ivec2 pix){
+    pix = ivec2(gl_GlobalInvocationID.xy);
+    if(pixel_list != 0){
+        const uint i = gl_WorkGroupID.x * (gl_WorkGroupSize.x * gl_WorkGroupSize.y) + gl_LocalInvocationIndex;
+        if(i >= list_count) return false;
+        pix = ivec2(list_pixels[i] & 0xffffu, list_pixels[i] >> 16);
+    }
+    const ivec2 size = imageSize(color);
+    return pix.x < size.x && pix.y < size.y;
+}
+
+// whether the previous frame's pixel saw the surface at p; misses only match misses
+bool same_surface(vec4 prev, vec3 p, vec4 hit){
+    if(hit.w < 0.0)
+        return prev.z < 0.0;
+    return prev.z >= 0.0 &&
+        abs(prev.z - distance(p, prev_eye)) < 0.05 * prev.z + 0.01 &&
+        dot(oct_decode(prev.xy), hit.xyz) > 0.9;
+}
+
+// blends col into the pixel's history; rd is its primary ray and hit the
+// first hit's normal and distance from the eye, w of -1 on a miss
+void accumulate(ivec2 pix, ivec2 size, vec3 rd, vec3 col, vec4 hit){
+    // color history with the sample count in alpha, and the second moment
+    // of luminance kept in the w of hits for adaptive.glsl
+    vec4 old = vec4(0.0);
+    float old_moment = 0.0;
+    const bool keep = history != 0 &&
+        !(all(greaterThanEqual(vec2(pix), reset_rect.xy)) && all(lessThanEqual(vec2(pix), reset_rect.zw)));
+    if(keep && (reproject == 0 || pixel_list != 0)){
+        old = imageLoad(prev_color, pix);
+        old_moment = imageLoad(prev_hits, pix).w;
+    }
+    else if(keep){
+        // where this pixel's first hit was in the previous frame,
+        // bilinear over the neighbours that saw the same surface
+        const vec3 p = EYE + rd * (hit.w < 0.0 ? FAR : hit.w);
+        const vec4 clip = prev_VP * vec4(p, 1.0);
+        if(clip.w > 0.0){
+            const vec2 src = (clip.xy / clip.w * 0.5 + 0.5) * vec2(size);
+            const ivec2 base = ivec2(floor(src));
+            const vec2 f = src - vec2(base);
+            float weights = 0.0;
+            for(int i = 0; i < 4; ++i){
+                const ivec2 offset = ivec2(i & 1, i >> 1);
+                const ivec2 tap = base + offset;
+                const vec2 w2 = mix(1.0 - f, f, vec2(offset));
+                const float w = w2.x * w2.y;
+                if(w <= 0.0 || any(lessThan(tap, ivec2(0))) || any(greaterThanEqual(tap, size)))
+                    continue;
+                const vec4 prev = imageLoad(prev_hits, tap);
+                if(same_surface(prev, p, hit)){
+                    old += w * imageLoad(prev_color, tap);
+                    old_moment += w * prev.w;
+                    weights += w;
+                }
+            }
+            old = weights > 0.001 ? old / weights : vec4(0.0);
+            old_moment = weights > 0.001 ? old_moment / weights : 0.0;
+        }
+    }
+    const float n = min(old.w, 16000000.0) + 1.0;
+    const float L = dot(col, vec3(0.2126, 0.7152, 0.0722));
+    imageStore(color, pix, vec4(mix(old.rgb, col, 1.0 / n), n));
+    imageStore(hits, pix, vec4(hit.w < 0.0 ? vec2(0.0) : oct_encode(hit.xyz), hit.w, mix(old_moment, L * L, 1.0 / n)));
+}
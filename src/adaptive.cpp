@@ -0,0 +1,41 @@
+#include "adaptive.h"
+#include "myglheaders.h"
+
+struct PixelListHeader{
+    unsigned groups[3];
+    unsigned count;
+};
+
+AdaptiveSampler::AdaptiveSampler()
+    : select("assets/adaptive.glsl"), width(0), height(0), enabled(false),
+    max_error(0.05f), min_samples(8){
+}
+
+void AdaptiveSampler::init(int w, int h, unsigned binding){
+    width = w;
+    height = h;
+    list.init(nullptr, 0, binding);
+    list.upload(nullptr, sizeof(PixelListHeader) + width * height * sizeof(unsigned));
+}
+
+void AdaptiveSampler::update(){
+    PixelListHeader header = {{0, 1, 1}, 0};
+    list.update(&header, sizeof(header));
+    select.bind();
+    select.setUniformFloat("max_error", max_error);
+    select.setUniformInt("min_samples", min_samples);
+    select.call((width + 7) / 8, (height + 7) / 8, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+void AdaptiveSampler::trace(ComputeShader& depth){
+    depth.setUniformInt("pixel_list", 1);
+    depth.callIndirect(list.handle());
+    depth.setUniformInt("pixel_list", 0);
+}
+
+unsigned AdaptiveSampler::count(){
+    PixelListHeader header;
+    list.read(&header, sizeof(header));
+    return header.count;
+}
@@ -0,0 +1,47 @@
+#version 430 core
+
+// one group of depth.glsl per this many listed pixels, its workgroup size
+#define ADAPTIVE_GROUP 64
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0, rgba32f) uniform writeonly image2D color;
+layout(binding = 5, rgba32f) uniform readonly image2D prev_color;
+layout(binding = 6, rgba32f) uniform writeonly image2D hits;
+layout(binding = 7, rgba32f) uniform readonly image2D prev_hits;
+
+layout(std430, binding = 9) buffer PIXEL_LIST_BUF
+{
+    uint list_groups_x; // indirect dispatch of depth.glsl
+    uint list_groups_y;
+    uint list_groups_z;
+    uint list_count;
+    uint list_pixels[]; // x in the low half, y in the high
+};
+
+uniform float max_error;  // relative standard error of a pixel's mean luminance
+uniform int min_samples;  // below which the variance is not trusted
+
+void main(){
+    const ivec2 pix = ivec2(gl_GlobalInvocationID.xy);
+    const ivec2 size = imageSize(prev_color);
+    if (pix.x >= size.x || pix.y >= size.y) return;
+
+    // every pixel carries its history forward, the listed ones are then
+    // overwritten by depth.glsl
+    const vec4 c = imageLoad(prev_color, pix);
+    const vec4 h = imageLoad(prev_hits, pix);
+    imageStore(color, pix, c);
+    imageStore(hits, pix, h);
+
+    const float n = c.w;
+    const float mean = dot(c.rgb, vec3(0.2126, 0.7152, 0.0722));
+    const float variance = max(h.w - mean * mean, 0.0);
+    const float error = sqrt(variance / max(n, 1.0)) / (mean + 0.01);
+    if(n < float(min_samples) || error > max_error){
+        const uint i = atomicAdd(list_count, 1u);
+        list_pixels[i] = uint(pix.x) | (uint(pix.y) << 16);
+        if(i % uint(ADAPTIVE_GROUP) == 0u)
+            atomicAdd(list_groups_x, 1u);
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include "compute_shader.h"
+#include "SSBO.h"
+
+// pixels per group of depth.glsl in its list mode, must match adaptive.glsl
+#define ADAPTIVE_GROUP 64
+
+/*
+    Adaptive sampling of a still camera's accumulation. depth.glsl keeps the
+    second moment of each pixel's luminance beside its colour; adaptive.glsl
+    carries every pixel's history forward and lists the ones whose mean
+    still has a relative standard error above max_error, along with the
+    group count of an indirect dispatch of depth.glsl over just those.
+
+    Runs after Reprojection::next, on the same images.
+*/
+class AdaptiveSampler{
+    ComputeShader select;
+    SSBO list;
+    unsigned width, height;
+    bool enabled;
+public:
+    float max_error;
+    int min_samples;
+    AdaptiveSampler();
+    void init(int width, int height, unsigned binding);
+    inline void toggle(){ enabled = !enabled; }
+    inline bool on()const{ return enabled; }
+    // lists the pixels to trace this frame
+    void update();
+    // traces the listed pixels, depth bound with its other uniforms set
+    void trace(ComputeShader& depth);
+    // pixels listed by the last update, waits for the gpu
+    unsigned count();
+};
+
+#endif
@@ -0,0 +1,1253 @@
+#include "benchmark.h"
+#include "myglheaders.h"
+#include "window.h"
+#include "camera.h"
+#include "compute_shader.h"
+#include "texture.h"
+#include "UBO.h"
+#include "uniforms.h"
+#include "sdf.h"
+#include "sdf_codegen.h"
+#include "brickmap.h"
+#include "cone.h"
+#include "reprojection.h"
+#include "adaptive.h"
+#include "denoise.h"
+#include "wavefront.h"
+#include "tilequeue.h"
+#include "sequence.h"
+#include "emitters.h"
+#include "lpv.h"
+#include "radiance_cache.h"
+#include "primary_cache.h"
+#include "materials.h"
+#include "SSBO.h"
+#include "sdf_cpu.h"
+#include "brdf.h"
+#include "cpu_tracer.h"
+#include "image.h"
+#include "timer.h"
+#include "scenes.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <random>
+
+#define BENCHMARK_FRAMES 16
+
+static Uniforms view_uniforms(int width, int height, const glm::vec3& eye, const glm::vec3& at)
+{
+    Camera camera;
+    camera.resize(width, height);
+    camera.setEye(eye);
+    camera.lookAt(at);
+    camera.update();
+
+    Uniforms uni;
+    uni.IVP = camera.getIVP();
+    uni.eye = glm::vec4(camera.getEye(), 1.0f);
+    uni.nfwh = glm::vec4(camera.getNear(), camera.getFar(), (float)width, (float)height);
+    uni.seed = glm::vec4(0.25f, 0.5f, 0.75f, 2.0f);
+    return uni;
+}
+
+// the default view of main
+static Uniforms benchmark_uniforms(int width, int height)
+{
+    return view_uniforms(width, height, glm::vec3(-1.0f, 4.0f, 10.0f), glm::vec3(0.0f));
+}
+
+#define PASS_CONE 0
+#define PASS_DEPTH 1
+#define PASS_COUNT 2
+
+// gpu time of each pass from timer queries, and the wall time around it
+// with the queue drained
+struct PassTimes
+{
+    double gpu[PASS_COUNT], wall[PASS_COUNT];
+    PassTimes(){ memset(this, 0, sizeof(PassTimes)); }
+};
+
+struct PassTimer
+{
+    Timer timer;
+    std::chrono::steady_clock::time_point wall;
+    void begin()
+    {
+        glFinish();
+        wall = std::chrono::steady_clock::now();
+        timer.begin();
+    }
+    void end(PassTimes& times, int pass)
+    {
+        times.gpu[pass] += timer.end();
+        glFinish();
+        times.wall[pass] += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wall).count();
+    }
+};
+
+// samples of the converged images the benchmarks measure error against
+#define REFERENCE_SAMPLES 1024
+
+// Everything depth.glsl reads, bound as in main. The brick map and the cone
+// prepass start off, but their images must still exist for the program to run.
+struct Bench
+{
+    Window window;
+    Uniforms uni;
+    UBO unibuf;
+    Reprojection history;
+    BrickMap bricks;
+    ConePrepass cone;
+    SampleSequence sequence;
+    EmitterList emitters;
+    RadianceVolume lpv;
+    RadianceCache cache;
+    PrimaryCache primary;
+    SSBO steps;
+    PassTimer timer;
+    unsigned x, y;
+    Bench(int width, int height, const char* title)
+        : window(width, height, 4, 3, title), uni(benchmark_uniforms(width, height)),
+        unibuf(&uni, sizeof(uni), 2), x((width + 7) / 8), y((height + 7) / 8)
+    {
+        history.init(width, height);
+        bricks.init(1, 2, 3, 6, 7);
+        cone.init(width, height, 4);
+        cone.toggle();
+        sequence.init(15);
+        emitters.init(16);
+        lpv.init(17);
+        cache.init(18);
+        primary.init(width, height, 19);
+        unsigned zero[4] = { 0, 0, 0, 0 };
+        steps.init(zero, sizeof(zero), 8);
+    }
+};
+
+// prepass is cone.glsl when the cone prepass is on; times, when set,
+// accumulates the time of both passes
+static void frame(Bench& b, ComputeShader& prog, SDF_Edits& edits, ComputeShader* prepass, PassTimes* times = nullptr)
+{
+    PassTimer& timer = b.timer;
+    b.emitters.update(edits);
+    if(prepass){
+        if(times)
+            timer.begin();
+        b.cone.run(*prepass, edits, b.bricks, 13);
+        if(times)
+            timer.end(*times, PASS_CONE);
+    }
+    if(times)
+        timer.begin();
+    prog.bind();
+    edits.uniform(prog);
+    b.bricks.uniform(prog, 13);
+    b.cone.uniform(prog);
+    b.lpv.uniform(prog);
+    b.cache.uniform(prog);
+    b.primary.uniform(prog);
+    prog.call(b.x, b.y, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    if(times)
+        timer.end(*times, PASS_DEPTH);
+}
+
+static double time_frames(Bench& b, ComputeShader& prog, SDF_Edits& edits, ComputeShader* prepass = nullptr)
+{
+    frame(b, prog, edits, prepass);
+    glFinish();
+    const double begin = glfwGetTime();
+    for(int i = 0; i < BENCHMARK_FRAMES; ++i){
+        frame(b, prog, edits, prepass);
+    }
+    glFinish();
+    return (glfwGetTime() - begin) * 1000.0 / BENCHMARK_FRAMES;
+}
+
+int codegen_benchmark(int width, int height)
+{
+    Bench b(width, height, "gputracer codegen benchmark");
+
+    SDF_Programs programs("assets/depth.glsl");
+    const int counts[] = { 10, 100, 1000 };
+    for(int count : counts){
+        SDF_Edits edits;
+        edits.init(3, 4, 5);
+        random_scene(edits, count);
+        edits.upload();
+
+        const double begin = glfwGetTime();
+        ComputeShader& specialized = programs.specialized(edits);
+        const double compile = (glfwGetTime() - begin) * 1000.0;
+
+        const double t0 = time_frames(b, programs.interpreter(), edits);
+        const double t1 = time_frames(b, specialized, edits);
+        printf("%4d edits: interpreter %8.3f ms, specialized %8.3f ms, %.2fx, compile %.1f ms\n",
+            count, t0, t1, t0 / t1, compile);
+    }
+    return 0;
+}
+
+static float central_distance(const SDF_Edits& edits, const glm::vec3& p, const glm::vec3& e)
+{
+    return sdf_map_dual(edits, p + e).d - sdf_map_dual(edits, p - e).d;
+}
+
+// largest 99th percentile angle, in degrees, gradient_accuracy accepts
+#define GRADIENT_P99_LIMIT 1.0f
+
+// angle in degrees between the dual gradient and central differences at
+// sphere traced hits, per blend type of the edit that was hit; returns how
+// many of those and all hits have a p99 over GRADIENT_P99_LIMIT
+static int gradient_accuracy(const SDF_Edits& edits, const Uniforms& uni)
+{
+    const int rays_x = 96, rays_y = 54;
+    const float h = 0.001f;
+    const char* names[] = { "union", "difference", "intersect", "smooth union", "smooth difference", "smooth intersect" };
+    Vector<float> errors[SDF_BLEND_COUNT];
+    Vector<float> all;
+
+    const glm::vec3 eye = glm::vec3(uni.eye);
+    for(int y = 0; y < rays_y; ++y){
+        for(int x = 0; x < rays_x; ++x){
+            const glm::vec4 t = uni.IVP * glm::vec4(
+                (x + 0.5f) / rays_x * 2.0f - 1.0f, (y + 0.5f) / rays_y * 2.0f - 1.0f, 0.0f, 1.0f);
+            const glm::vec3 rd = glm::normalize(glm::vec3(t) / t.w - eye);
+
+            glm::vec3 p = eye;
+            SDFDual d;
+            bool hit = false;
+            for(int i = 0; i < 256 && !hit; ++i){
+                d = sdf_map_dual(edits, p);
+                if(glm::abs(d.d) < 0.0001f)
+                    hit = true;
+                else if(glm::length(p - eye) > uni.nfwh.y)
+                    break;
+                else
+                    p += rd * d.d;
+            }
+            if(!hit || d.id < 0 || glm::length(d.g) == 0.0f)
+                continue;
+
+            const glm::vec3 central = glm::vec3(
+                central_distance(edits, p, glm::vec3(h, 0.0f, 0.0f)),
+                central_distance(edits, p, glm::vec3(0.0f, h, 0.0f)),
+                central_distance(edits, p, glm::vec3(0.0f, 0.0f, h)));
+            if(glm::length(central) == 0.0f)
+                continue;
+            const float c = glm::dot(glm::normalize(d.g), glm::normalize(central));
+            const float angle = glm::degrees(acosf(glm::clamp(c, -1.0f, 1.0f)));
+            errors[edits[d.id].blend_type()].grow() = angle;
+            all.grow() = angle;
+        }
+    }
+
+    printf("normals at %d of %d hits, degrees from central differences (h = %g):\n",
+        all.count(), rays_x * rays_y, h);
+    int failed = all.count() ? 0 : 1;
+    for(int i = 0; i <= SDF_BLEND_COUNT; ++i){
+        Vector<float>& e = i < SDF_BLEND_COUNT ? errors[i] : all;
+        if(!e.count())
+            continue;
+        std::sort(e.begin(), e.end());
+        double sum = 0.0;
+        int over = 0;
+        for(int j = 0; j < e.count(); ++j){
+            sum += e[j];
+            over += e[j] > 1.0f ? 1 : 0;
+        }
+        const float p99 = e[(e.count() * 99) / 100];
+        failed += p99 > GRADIENT_P99_LIMIT ? 1 : 0;
+        printf("%18s: %5d hits, mean %7.4f, median %7.4f, p99 %7.4f, max %8.4f, %d over 1 degree%s\n",
+            i < SDF_BLEND_COUNT ? names[i] : "all", e.count(), sum / e.count(),
+            e[e.count() / 2], p99, e.back(), over, p99 > GRADIENT_P99_LIMIT ? ", FAILED" : "");
+    }
+    return failed;
+}
+
+int gradient_check(int width, int height)
+{
+    SDF_Edits edits;
+    random_scene(edits, 100);
+    return gradient_accuracy(edits, benchmark_uniforms(width, height)) ? 1 : 0;
+}
+
+int gradient_benchmark(int width, int height)
+{
+    Bench b(width, height, "gputracer gradient benchmark");
+
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    random_scene(edits, 100);
+    edits.upload();
+
+    if(gradient_accuracy(edits, b.uni))
+        return 1;
+
+    SDF_Programs programs("assets/depth.glsl");
+    ComputeShader* progs[] = { &programs.interpreter(), &programs.specialized(edits) };
+    const char* names[] = { "interpreter", "specialized" };
+    for(int i = 0; i < 2; ++i){
+        ComputeShader& prog = *progs[i];
+        prog.bind();
+        prog.setUniformInt("central_normals", 1);
+        const double central = time_frames(b, prog, edits);
+        prog.setUniformInt("central_normals", 0);
+        const double dual = time_frames(b, prog, edits);
+        printf("%s: central differences %8.3f ms, dual %8.3f ms, %.2fx\n",
+            names[i], central, dual, central / dual);
+    }
+    return 0;
+}
+
+// STEP_BUF after one frame: primary march steps, those of the cones when
+// prepass is set, then the rays of every bounce and their steps
+static void count_steps(Bench& b, ComputeShader& prog, SDF_Edits& edits, ComputeShader* prepass, unsigned* counts)
+{
+    counts[0] = counts[1] = counts[2] = counts[3] = 0;
+    b.steps.update(counts, 4 * sizeof(unsigned));
+    prog.bind();
+    prog.setUniformInt("count_steps", 1);
+    if(prepass){
+        prepass->bind();
+        prepass->setUniformInt("count_steps", 1);
+    }
+    frame(b, prog, edits, prepass);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    b.steps.read(counts, 4 * sizeof(unsigned));
+    prog.bind();
+    prog.setUniformInt("count_steps", 0);
+    if(prepass){
+        prepass->bind();
+        prepass->setUniformInt("count_steps", 0);
+    }
+}
+
+#define BRICK_CHECK_POINTS 128
+
+// points over the committed edits' bounds the brick cache gives too large
+// a distance at, see brick_check.glsl
+static void brick_check(Bench& b, SDF_Edits& edits, ComputeShader& check, const char* name)
+{
+    // the step counters double as the check's
+    unsigned counts[4] = { 0, 0, 0, 0 };
+    b.steps.update(counts, sizeof(counts));
+    const AABB box = edits.committed_bounds();
+    check.bind();
+    edits.uniform(check);
+    b.bricks.uniform(check, 13);
+    check.setUniform("check_lo", box.lo);
+    check.setUniform("check_hi", box.hi);
+    check.setUniformInt("check_points", BRICK_CHECK_POINTS);
+    check.call(BRICK_CHECK_POINTS / 4, BRICK_CHECK_POINTS / 4, BRICK_CHECK_POINTS / 4);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    b.steps.read(counts, sizeof(counts));
+    float worst;
+    memcpy(&worst, &counts[2], sizeof(worst));
+    printf("%-16s: %u of %u points overestimate the edits by more than a sample spacing, by up to %.4f, %u bricks in use\n",
+        name, counts[1], counts[0], counts[1] ? worst : 0.0f, b.bricks.bricks_used());
+}
+
+int brick_benchmark(int width, int height)
+{
+    Bench b(width, height, "gputracer brick check");
+    b.bricks.toggle();
+    ComputeShader check("assets/brick_check.glsl");
+
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    random_scene(edits, 32);
+    edits.upload();
+    b.bricks.update(edits);
+    brick_check(b, edits, check, "full bake");
+
+    // spheres in the open above the ground, where the cells were empty,
+    // committed one at a time so each only rebakes the cells around it
+    for(int i = 0; i < 4; ++i){
+        edit_params p;
+        p.t = glm::vec3(-6.0f + 4.0f * i, 1.2f, 0.5f);
+        p.s = glm::vec3(0.5f);
+        p.blend_type = i & 1 ? SDF_BLEND_SMTH_UNION : SDF_BLEND_UNION;
+        edits.update_brush(p);
+        edits.add_edit();
+        edits.upload();
+        b.bricks.update(edits);
+    }
+    brick_check(b, edits, check, "after 4 unions");
+    edits.undo();
+    edits.upload();
+    b.bricks.update(edits);
+    brick_check(b, edits, check, "after an undo");
+
+    // committing and undoing the brush over and over takes the bricks the
+    // undos free again, so the count in use stays put
+    for(int i = 0; i < 16; ++i){
+        edits.add_edit();
+        edits.upload();
+        b.bricks.update(edits);
+        edits.undo();
+        edits.upload();
+        b.bricks.update(edits);
+    }
+    brick_check(b, edits, check, "after 16 cycles");
+    return 0;
+}
+
+int cone_benchmark(int width, int height)
+{
+    Bench b(width, height, "gputracer cone benchmark");
+
+    ComputeShader depth("assets/depth.glsl");
+    ComputeShader prepass("assets/cone.glsl");
+    const int counts[] = { 10, 100 };
+    for(int count : counts){
+        SDF_Edits edits;
+        edits.init(3, 4, 5);
+        random_scene(edits, count);
+        edits.upload();
+
+        unsigned off[4], on[4];
+        count_steps(b, depth, edits, nullptr, off);
+        const double t0 = time_frames(b, depth, edits);
+        b.cone.toggle();
+        count_steps(b, depth, edits, &prepass, on);
+        const double t1 = time_frames(b, depth, edits, &prepass);
+        b.cone.toggle();
+
+        const float pixels = b.uni.nfwh.z * b.uni.nfwh.w;
+        printf("%4d edits: primary steps per pixel %.2f without the prepass, %.2f with it plus %.3f for the cones, %.1f%% fewer\n",
+            count, float(off[0]) / pixels, float(on[0]) / pixels, float(on[1]) / pixels,
+            100.0f * (1.0f - float(on[0] + on[1]) / off[0]));
+        printf("%4d edits: frame %8.3f ms without the prepass, %8.3f ms with it, %.2fx\n",
+            count, t0, t1, t0 / t1);
+    }
+    return 0;
+}
+
+#define SUITE_SAMPLES 4
+#define SUITE_VIEWS 4
+#define SUITE_PATHS 3
+
+static const char* const suite_paths[SUITE_PATHS] = { "orbit", "ground", "overhead" };
+
+// camera of a suite path at t in [0, 1)
+static void suite_view(int path, float t, glm::vec3& eye, glm::vec3& at)
+{
+    switch(path){
+        case 0:
+            // around the scene, looking at its centre
+            eye = glm::vec3(12.0f * cosf(t * 6.283185f), 4.0f, 12.0f * sinf(t * 6.283185f));
+            at = glm::vec3(0.0f);
+        break;
+        case 1:
+            // just above the ground plane, where rays graze it for many steps
+            eye = glm::vec3(-8.0f + 16.0f * t, -0.5f, 8.0f);
+            at = eye + glm::vec3(0.3f, 0.0f, -1.0f);
+        break;
+        default:
+            // high above, looking down over most of the edits
+            eye = glm::vec3(-6.0f + 12.0f * t, 18.0f, 0.0f);
+            at = glm::vec3(eye.x, -1.0f, 2.0f);
+        break;
+    }
+}
+
+struct SuiteRun
+{
+    int edits;
+    bool generated;
+    int path;
+    PassTimes ms;    // per frame
+    double rays, ray_steps, primary_steps, cone_steps;    // per frame
+};
+
+static void write_suite_json(const char* filename, const SuiteRun* runs, int count, int width, int height)
+{
+    FILE* f = fopen(filename, "w");
+    if(!f){
+        printf("could not open %s\n", filename);
+        return;
+    }
+    fprintf(f, "{\n  \"renderer\": \"%s\",\n", (const char*)glGetString(GL_RENDERER));
+    fprintf(f, "  \"width\": %d,\n  \"height\": %d,\n  \"samples\": %d,\n  \"views\": %d,\n  \"runs\": [\n",
+        width, height, SUITE_SAMPLES, SUITE_VIEWS);
+    const double pixels = double(width) * height;
+    for(int i = 0; i < count; ++i){
+        const SuiteRun& r = runs[i];
+        fprintf(f, "    {\"edits\": %d, \"program\": \"%s\", \"path\": \"%s\", "
+            "\"cone_gpu_ms\": %.4f, \"depth_gpu_ms\": %.4f, \"cone_ms\": %.4f, \"depth_ms\": %.4f, "
+            "\"rays_per_s\": %.0f, \"steps_per_ray\": %.3f, "
+            "\"primary_steps_per_pixel\": %.3f, \"cone_steps_per_pixel\": %.4f}%s\n",
+            r.edits, r.generated ? "generated" : "interpreter", suite_paths[r.path],
+            r.ms.gpu[PASS_CONE], r.ms.gpu[PASS_DEPTH], r.ms.wall[PASS_CONE], r.ms.wall[PASS_DEPTH],
+            r.rays / (r.ms.wall[PASS_DEPTH] * 1e-3), r.ray_steps / r.rays,
+            r.primary_steps / pixels, r.cone_steps / pixels, i + 1 < count ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+}
+
+int suite_benchmark(int width, int height, const char* json)
+{
+    Bench b(width, height, "gputracer benchmark suite");
+    b.cone.toggle();
+
+    SDF_Programs depth_programs("assets/depth.glsl");
+    SDF_Programs cone_programs("assets/cone.glsl");
+    const int counts[] = { 1, 32, 256, 4096 };
+    Vector<SuiteRun> runs;
+    for(int count : counts){
+        SDF_Edits edits;
+        edits.init(3, 4, 5);
+        random_scene(edits, count);
+        edits.upload();
+        const bool generated = edits.count() - 1 <= SDF_CODEGEN_MAX_EDITS;
+        ComputeShader& depth = generated ? depth_programs.specialized(edits) : depth_programs.interpreter();
+        ComputeShader& prepass = generated ? cone_programs.specialized(edits) : cone_programs.interpreter();
+
+        for(int path = 0; path < SUITE_PATHS; ++path){
+            SuiteRun& run = runs.grow();
+            run = SuiteRun();
+            run.edits = count;
+            run.generated = generated;
+            run.path = path;
+            for(int v = 0; v < SUITE_VIEWS; ++v){
+                glm::vec3 eye, at;
+                suite_view(path, float(v) / SUITE_VIEWS, eye, at);
+                b.uni = view_uniforms(width, height, eye, at);
+                for(int i = 0; i < SUITE_SAMPLES; ++i){
+                    b.uni.seed = glm::vec4(0.25f + 0.1f * i, 0.5f, 0.75f, float(i + 1));
+                    b.unibuf.upload(&b.uni, sizeof(b.uni));
+                    // counted apart from the timed frames, the atomics are not free;
+                    // this also leaves the driver's compile out of the timings
+                    if(i == 0){
+                        unsigned c[4];
+                        count_steps(b, depth, edits, &prepass, c);
+                        run.primary_steps += c[0];
+                        run.cone_steps += c[1];
+                        run.rays += c[2];
+                        run.ray_steps += c[3];
+                    }
+                    frame(b, depth, edits, &prepass, &run.ms);
+                }
+            }
+            for(int p = 0; p < PASS_COUNT; ++p){
+                run.ms.gpu[p] /= SUITE_VIEWS * SUITE_SAMPLES;
+                run.ms.wall[p] /= SUITE_VIEWS * SUITE_SAMPLES;
+            }
+            run.primary_steps /= SUITE_VIEWS;
+            run.cone_steps /= SUITE_VIEWS;
+            run.rays /= SUITE_VIEWS;
+            run.ray_steps /= SUITE_VIEWS;
+            printf("%4d edits, %-8s: cone %8.3f ms (gpu %8.3f), depth %8.3f ms (gpu %8.3f), %8.3f Mrays/s, %6.2f steps per ray\n",
+                count, suite_paths[path], run.ms.wall[PASS_CONE], run.ms.gpu[PASS_CONE],
+                run.ms.wall[PASS_DEPTH], run.ms.gpu[PASS_DEPTH],
+                run.rays / (run.ms.wall[PASS_DEPTH] * 1e3), run.ray_steps / run.rays);
+        }
+    }
+
+    write_suite_json(json, runs.begin(), runs.count(), width, height);
+    printf("wrote %s\n", json);
+    return 0;
+}
+
+#define ADAPTIVE_REFERENCE_SAMPLES 256
+#define ADAPTIVE_MAX_FRAMES 256
+
+// a colour as frag.glsl tonemaps it
+static glm::vec3 tonemap(const glm::vec3& c)
+{
+    const glm::vec3 x = glm::max(c, glm::vec3(0.0f));
+    return glm::pow(x / (glm::vec3(1.0f) + x), glm::vec3(1.0f / 2.2f));
+}
+
+// mean absolute difference of the colours as frag.glsl tonemaps them
+static float tonemapped_error(const Vector<glm::vec4>& a, const Vector<glm::vec4>& b)
+{
+    double sum = 0.0;
+    for(int i = 0; i < a.count(); ++i){
+        const glm::vec3 d = glm::abs(tonemap(glm::vec3(a[i])) - tonemap(glm::vec3(b[i])));
+        sum += d.x + d.y + d.z;
+    }
+    return float(sum / (3.0 * a.count()));
+}
+
+// root mean square difference of the colours as frag.glsl tonemaps them
+static float tonemapped_rmse(const Vector<glm::vec4>& a, const Vector<glm::vec4>& b)
+{
+    double sum = 0.0;
+    for(int i = 0; i < a.count(); ++i){
+        const glm::vec3 d = tonemap(glm::vec3(a[i])) - tonemap(glm::vec3(b[i]));
+        sum += glm::dot(d, d);
+    }
+    return float(sqrt(sum / (3.0 * a.count())));
+}
+
+struct Convergence
+{
+    int frames;
+    double ms;          // tracing and, when adaptive, listing; error checks excluded
+    double samples;     // pixel samples traced
+    float error;
+};
+
+// accumulates up to max_frames samples of a still camera, every pixel each
+// frame or only those adaptive lists, until image is within target of reference;
+// traced by prog, or by wavefront when set; from a first frame past 0 it
+// adds to the history of the last call instead of starting over
+static Convergence converge(Bench& b, ComputeShader& prog, Wavefront* wavefront, SDF_Edits& edits, Texture4uc* textures,
+    AdaptiveSampler* adaptive, int max_frames, const Vector<glm::vec4>* reference, float target, Vector<glm::vec4>& image,
+    int first = 0)
+{
+    const int pixels = image.count();
+    const float irm = 1.0f / RAND_MAX;
+    srand(1 + first);
+    Convergence c = { 0, 0.0, 0.0, 1.0f };
+    while(c.frames < max_frames){
+        const int i = first + c.frames++;
+        b.uni.seed = glm::vec4(rand() * irm, rand() * irm, rand() * irm, float(i + 1));
+        b.unibuf.upload(&b.uni, sizeof(b.uni));
+        b.history.next(b.uni.IVP, glm::vec3(b.uni.eye));
+        b.emitters.update(edits);
+        b.cache.update(edits);
+        b.primary.update(edits, b.uni.IVP);
+
+        glFinish();
+        const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        const bool listed = adaptive && i > 0;
+        if(listed)
+            adaptive->update();
+        auto setup = [&](ComputeShader& p){
+            for(int t = 0; t < MATERIAL_TEXTURE_COUNT; ++t){
+                textures[t].bind(4 + t, material_samplers[t], p);
+            }
+            edits.uniform(p);
+            b.bricks.uniform(p, 13);
+            b.cone.uniform(p);
+            b.lpv.uniform(p);
+            b.cache.uniform(p);
+            b.primary.uniform(p);
+            b.history.uniform(p, i > 0);
+        };
+        if(wavefront){
+            wavefront->trace(edits, setup, listed ? adaptive : nullptr);
+        }
+        else{
+            prog.bind();
+            setup(prog);
+            if(listed)
+                adaptive->trace(prog);
+            else
+                prog.call(b.x, b.y, 1);
+        }
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+        glFinish();
+        c.ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        c.samples += listed ? double(adaptive->count()) : double(pixels);
+
+        if(reference){
+            b.history.color().download(image.begin());
+            c.error = tonemapped_error(image, *reference);
+            if(c.error <= target)
+                break;
+        }
+    }
+    if(!reference)
+        b.history.color().download(image.begin());
+    return c;
+}
+
+int adaptive_benchmark(int width, int height, float target)
+{
+    Bench b(width, height, "gputracer adaptive benchmark");
+    // the camera never moves
+    b.history.toggle();
+    Texture4uc textures[MATERIAL_TEXTURE_COUNT];
+    for(int i = 0; i < MATERIAL_TEXTURE_COUNT; ++i){
+        textures[i].init(material_files[i]);
+    }
+    AdaptiveSampler adaptive;
+    adaptive.init(width, height, 9);
+
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    random_scene(edits, 32);
+    edits.upload();
+    SDF_Programs programs("assets/depth.glsl");
+    ComputeShader& prog = programs.specialized(edits);
+
+    Vector<glm::vec4> reference, image;
+    reference.resize(width * height);
+    image.resize(width * height);
+    const Convergence ref = converge(b, prog, nullptr, edits, textures, nullptr, ADAPTIVE_REFERENCE_SAMPLES, nullptr, 0.0f, reference);
+    printf("reference: %d samples in %.1f ms\n", ADAPTIVE_REFERENCE_SAMPLES, ref.ms);
+
+    const Convergence uniform = converge(b, prog, nullptr, edits, textures, nullptr, ADAPTIVE_MAX_FRAMES, &reference, target, image);
+    const Convergence adapted = converge(b, prog, nullptr, edits, textures, &adaptive, ADAPTIVE_MAX_FRAMES, &reference, target, image);
+    const Convergence* runs[] = { &uniform, &adapted };
+    const char* names[] = { "uniform", "adaptive" };
+    for(int i = 0; i < 2; ++i){
+        const Convergence& c = *runs[i];
+        printf("%-8s: error %.5f after %3d frames, %9.1f ms, %.2f samples per pixel%s\n", names[i], c.error, c.frames,
+            c.ms, c.samples / (width * height), c.error <= target ? "" : ", target not reached");
+    }
+    printf("target %.4f, max error %.3f, min samples %d: adaptive took %.2fx the time of uniform\n",
+        target, adaptive.max_error, adaptive.min_samples, adapted.ms / uniform.ms);
+    return 0;
+}
+
+int denoise_benchmark(int width, int height)
+{
+    Bench b(width, height, "gputracer denoise benchmark");
+    b.history.toggle();
+    Texture4uc textures[MATERIAL_TEXTURE_COUNT];
+    for(int i = 0; i < MATERIAL_TEXTURE_COUNT; ++i){
+        textures[i].init(material_files[i]);
+    }
+    FrameTimers timers;
+    Denoiser denoiser;
+    denoiser.init(width, height, 10, &timers);
+    denoiser.toggle();
+
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    random_scene(edits, 32);
+    edits.upload();
+    SDF_Programs programs("assets/depth.glsl");
+    ComputeShader& prog = programs.specialized(edits);
+    // converge leaves the program's other uniforms alone
+    prog.bind();
+    denoiser.uniform(prog);
+
+    Vector<glm::vec4> reference, image;
+    reference.resize(width * height);
+    image.resize(width * height);
+    converge(b, prog, nullptr, edits, textures, nullptr, ADAPTIVE_REFERENCE_SAMPLES, nullptr, 0.0f, reference);
+
+    for(int samples = 1; samples <= 64; samples *= 2){
+        const Convergence c = converge(b, prog, nullptr, edits, textures, nullptr, samples, nullptr, 0.0f, image);
+        const float noisy = tonemapped_error(image, reference);
+        denoiser.run(b.history);
+        timers.endFrame();
+        glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+        denoiser.output().download(image.begin());
+        printf("%2d samples: error %.5f, denoised %.5f, %8.1f ms of tracing\n", samples, noisy,
+            tonemapped_error(image, reference), c.ms);
+    }
+    // results arrive a few frames late
+    for(int i = 0; i < 2 * TIMER_FRAMES; ++i){
+        denoiser.run(b.history);
+        glFinish();
+        timers.endFrame();
+    }
+    printf("denoiser passes:\n");
+    timers.print();
+    return 0;
+}
+
+/*
+    What the benchmarks against a converged image share: a still camera,
+    the material textures, the generated depth.glsl of their scenes and
+    the reference and working images.
+*/
+struct Still
+{
+    Bench b;
+    Texture4uc textures[MATERIAL_TEXTURE_COUNT];
+    SDF_Programs programs;
+    Vector<glm::vec4> reference, image;
+    Still(int width, int height, const char* title)
+        : b(width, height, title), programs("assets/depth.glsl")
+    {
+        b.history.toggle();
+        for(int i = 0; i < MATERIAL_TEXTURE_COUNT; ++i){
+            textures[i].init(material_files[i]);
+        }
+        reference.resize(width * height);
+        image.resize(width * height);
+    }
+    // uploads edits and waits for their program
+    ComputeShader& program(SDF_Edits& edits)
+    {
+        edits.upload();
+        return programs.specialized(edits);
+    }
+};
+
+// converges REFERENCE_SAMPLES of prog into s.reference and prints their time after name
+static void reference_image(Still& s, ComputeShader& prog, SDF_Edits& edits, const char* name)
+{
+    const Convergence c = converge(s.b, prog, nullptr, edits, s.textures, nullptr, REFERENCE_SAMPLES, nullptr, 0.0f, s.reference);
+    printf("%s: %d samples in %.1f ms\n", name, REFERENCE_SAMPLES, c.ms);
+}
+
+// prints the error against s.reference after 1, 4, 16 and 64 samples of
+// prog and returns the last; ms is the time per sample
+static float rmse_row(Still& s, ComputeShader& prog, SDF_Edits& edits, const char* name, double& ms)
+{
+    printf("%-10s: rmse", name);
+    ms = 0.0;
+    float rmse = 0.0f;
+    int samples = 0;
+    for(int count = 1; count <= 64; count *= 4){
+        const Convergence c = converge(s.b, prog, nullptr, edits, s.textures, nullptr, count, nullptr, 0.0f, s.image);
+        rmse = tonemapped_rmse(s.image, s.reference);
+        ms += c.ms;
+        samples += count;
+        printf(" %.5f at %d,", rmse, count);
+    }
+    ms /= samples;
+    return rmse;
+}
+
+int sequence_benchmark(int width, int height)
+{
+    Still s(width, height, "gputracer sequence benchmark");
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    random_scene(edits, 32);
+    ComputeShader& prog = s.program(edits);
+
+    // by the hash, which shares no points with the sequences
+    prog.bind();
+    s.b.sequence.set_mode(SEQUENCE_HASH);
+    s.b.sequence.uniform(prog);
+    reference_image(s, prog, edits, "reference");
+
+    float hash_rmse = 0.0f;
+    for(int mode = 0; mode < SEQUENCE_COUNT; ++mode){
+        prog.bind();
+        s.b.sequence.set_mode(mode);
+        s.b.sequence.uniform(prog);
+        double ms;
+        const float rmse = rmse_row(s, prog, edits, SampleSequence::mode_name(mode), ms);
+        if(mode == SEQUENCE_HASH)
+            hash_rmse = rmse;
+        printf(" %.3f ms per sample, %.2fx the error of the hash\n", ms, rmse / hash_rmse);
+    }
+    return 0;
+}
+
+#define BRDF_CHECK_SAMPLES (1 << 20)
+
+// mean and variance of the luminance of the throughput of one bounce off
+// N = z, by uniform hemisphere directions and by sample_brdf
+static void brdf_estimates(const glm::vec3& V, const glm::vec3& albedo, float metalness, float roughness,
+    double* mean, double* variance)
+{
+    const glm::vec3 N(0.0f, 0.0f, 1.0f);
+    const glm::vec3 lum(0.2126f, 0.7152f, 0.0722f);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> uni(0.0f, 1.0f);
+    double sum[2] = { 0.0, 0.0 }, sq[2] = { 0.0, 0.0 };
+    for(int i = 0; i < BRDF_CHECK_SAMPLES; ++i){
+        const float u0 = uni(rng);
+        const float u1 = uni(rng);
+        const glm::vec2 u(u0, u1);
+        const glm::vec3 L = uniform_hemisphere(N, u);
+        glm::vec3 weight;
+        sample_brdf(V, N, albedo, metalness, roughness, u, weight);
+        const double x[2] = {
+            glm::dot(pbr_lighting(V, L, N, albedo, metalness, roughness), lum),
+            glm::dot(weight, lum) };
+        for(int e = 0; e < 2; ++e){
+            sum[e] += x[e];
+            sq[e] += x[e] * x[e];
+        }
+    }
+    for(int e = 0; e < 2; ++e){
+        mean[e] = sum[e] / BRDF_CHECK_SAMPLES;
+        variance[e] = sq[e] / BRDF_CHECK_SAMPLES - mean[e] * mean[e];
+    }
+}
+
+// both estimators must agree within the noise of 2^20 samples, returns
+// how many of the cases they disagree in
+static int brdf_check()
+{
+    const glm::vec3 albedo(0.95f, 0.64f, 0.54f);
+    const float roughness[] = { 0.1f, 0.3f, 0.6f, 1.0f };
+    const float cosines[] = { 0.95f, 0.5f, 0.1f };
+    int failed = 0;
+    printf("one bounce throughput, uniform hemisphere against sample_brdf, %d samples each:\n", BRDF_CHECK_SAMPLES);
+    for(int metal = 0; metal < 2; ++metal){
+        for(float r : roughness){
+            for(float c : cosines){
+                const glm::vec3 V(sqrtf(1.0f - c * c), 0.0f, c);
+                double mean[2], variance[2];
+                brdf_estimates(V, albedo, float(metal), r, mean, variance);
+                const double error = sqrt((variance[0] + variance[1]) / BRDF_CHECK_SAMPLES);
+                const double z = fabs(mean[0] - mean[1]) / glm::max(error, 1e-12);
+                failed += z > 4.0 ? 1 : 0;
+                printf("metalness %d, roughness %.1f, cos %.2f: %.5f against %.5f, %5.2f standard errors%s, variance %.2fx\n",
+                    metal, r, c, mean[0], mean[1], z, z > 4.0 ? " FAILED" : "", variance[1] / glm::max(variance[0], 1e-12));
+            }
+        }
+    }
+    printf("%s\n", failed ? "estimators disagree" : "estimators agree");
+    return failed;
+}
+
+int brdf_benchmark(int width, int height)
+{
+    if(brdf_check())
+        return 1;
+
+    Still s(width, height, "gputracer brdf benchmark");
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    random_scene(edits, 32);
+    ComputeShader& prog = s.program(edits);
+
+    prog.bind();
+    prog.setUniformInt("uniform_hemisphere", 0);
+    reference_image(s, prog, edits, "reference");
+
+    const char* names[] = { "importance", "uniform" };
+    float rmse[2];
+    double ms[2];
+    for(int i = 1; i >= 0; --i){
+        prog.bind();
+        prog.setUniformInt("uniform_hemisphere", i);
+        rmse[i] = rmse_row(s, prog, edits, names[i], ms[i]);
+        printf(" %.3f ms per sample\n", ms[i]);
+    }
+    printf("importance sampling: %.2fx the error of uniform at 64 samples\n", rmse[0] / rmse[1]);
+    return 0;
+}
+
+int light_benchmark(int width, int height)
+{
+    Still s(width, height, "gputracer light benchmark");
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    small_lights_scene(edits);
+    ComputeShader& prog = s.program(edits);
+
+    reference_image(s, prog, edits, "reference");
+    printf("%d emitters\n", s.b.emitters.emitter_count());
+
+    const char* names[] = { "brdf only", "emitters" };
+    float rmse[2];
+    for(int i = 0; i < 2; ++i){
+        if(s.b.emitters.on() != (i == 1))
+            s.b.emitters.toggle();
+        double ms;
+        rmse[i] = rmse_row(s, prog, edits, names[i], ms);
+        printf(" %.3f ms per sample\n", ms);
+    }
+    printf("light sampling: %.2fx the error of brdf sampling alone at 64 samples\n", rmse[1] / rmse[0]);
+    return 0;
+}
+
+// rays marched per path by prog over 4 samples
+static float rays_per_path(Still& s, ComputeShader& prog, SDF_Edits& edits)
+{
+    unsigned counts[4] = { 0, 0, 0, 0 };
+    s.b.steps.update(counts, sizeof(counts));
+    prog.bind();
+    prog.setUniformInt("count_steps", 1);
+    converge(s.b, prog, nullptr, edits, s.textures, nullptr, 4, nullptr, 0.0f, s.image);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    s.b.steps.read(counts, sizeof(counts));
+    prog.bind();
+    prog.setUniformInt("count_steps", 0);
+    return float(counts[2]) / (4.0f * s.image.count());
+}
+
+int roulette_benchmark(int width, int height)
+{
+    Still s(width, height, "gputracer roulette benchmark");
+    const char* materials[] = { "light", "wood", "copper" };
+    for(int m : { 1, 2, 0 }){
+        SDF_Edits edits;
+        edits.init(3, 4, 5);
+        small_lights_scene(edits, m);
+        ComputeShader& prog = s.program(edits);
+
+        s.b.uni.limits.w = 0;
+        char name[32];
+        snprintf(name, sizeof(name), "%s reference", materials[m]);
+        reference_image(s, prog, edits, name);
+
+        const char* names[] = { "fixed", "roulette" };
+        float rmse[2];
+        double ms[2];
+        for(int i = 0; i < 2; ++i){
+            s.b.uni.limits.w = i;
+            rmse[i] = rmse_row(s, prog, edits, names[i], ms[i]);
+            printf(" %.3f ms per sample, %.0f paths/s, %.2f rays per path\n",
+                ms[i], s.image.count() * 1000.0 / ms[i], rays_per_path(s, prog, edits));
+        }
+        // the time to a given error goes as the variance times the time per sample
+        printf("%s: roulette traces %.2fx the paths/s, %.2fx at equal noise\n", materials[m],
+            ms[0] / ms[1], (rmse[0] * rmse[0] * ms[0]) / (rmse[1] * rmse[1] * ms[1]));
+    }
+    s.b.uni.limits.w = 1;
+    return 0;
+}
+
+int cache_benchmark(int width, int height)
+{
+    Still s(width, height, "gputracer cache benchmark");
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    small_lights_scene(edits);
+    ComputeShader& prog = s.program(edits);
+
+    reference_image(s, prog, edits, "reference");
+
+    double ms;
+    const float rmse = rmse_row(s, prog, edits, "no cache", ms);
+    printf(" %.3f ms per sample\n", ms);
+    RadianceCache& cache = s.b.cache;
+    cache.toggle();
+    for(int bits : { 12, 15, 18 }){
+        cache.resize(1 << bits);
+        cache.clear();
+        cache.stats();
+        char name[16];
+        snprintf(name, sizeof(name), "2^%d cells", bits);
+        double cached_ms;
+        const float cached = rmse_row(s, prog, edits, name, cached_ms);
+        const RadianceCache::Stats st = cache.stats();
+        // the time to a given error goes as the variance times the time per sample
+        printf(" %.3f ms per sample, %.1f%% in use, %.1f%% of lookups hit, %u dropped, %.2fx at equal error\n",
+            cached_ms, 100.0f * st.occupancy, 100.0f * st.hit_rate, st.dropped,
+            (rmse * rmse * ms) / (cached * cached * cached_ms));
+    }
+    cache.toggle();
+    cache.resize(CACHE_CELLS);
+    return 0;
+}
+
+// primary march steps per pixel and sample over a round of every jitter of the primary cache
+static float primary_steps(Still& s, ComputeShader& prog, SDF_Edits& edits)
+{
+    unsigned counts[4] = { 0, 0, 0, 0 };
+    s.b.steps.update(counts, sizeof(counts));
+    prog.bind();
+    prog.setUniformInt("count_steps", 1);
+    converge(s.b, prog, nullptr, edits, s.textures, nullptr, PRIMARY_JITTERS, nullptr, 0.0f, s.image);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    s.b.steps.read(counts, sizeof(counts));
+    prog.bind();
+    prog.setUniformInt("count_steps", 0);
+    return float(counts[0]) / (float(PRIMARY_JITTERS) * s.image.count());
+}
+
+int primary_benchmark(int width, int height)
+{
+    Still s(width, height, "gputracer primary benchmark");
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    small_lights_scene(edits);
+    ComputeShader& prog = s.program(edits);
+
+    reference_image(s, prog, edits, "reference");
+
+    double ms;
+    const float rmse = rmse_row(s, prog, edits, "no cache", ms);
+    printf(" %.3f ms per sample, %.2f primary steps per sample\n", ms, primary_steps(s, prog, edits));
+
+    s.b.primary.toggle();
+    // the first round of jitters fills the cache
+    const float cold = primary_steps(s, prog, edits);
+    const float warm = primary_steps(s, prog, edits);
+    double cached_ms;
+    const float cached = rmse_row(s, prog, edits, "cache", cached_ms);
+    // the time to a given error goes as the variance times the time per sample
+    printf(" %.3f ms per sample, %.2f primary steps per sample filling it and %.2f once full, %.2fx the samples/s, %.2fx at equal error\n",
+        cached_ms, cold, warm, ms / cached_ms, (rmse * rmse * ms) / (cached * cached * cached_ms));
+    s.b.primary.toggle();
+    return 0;
+}
+
+// samples of the image before the edit of reset_benchmark
+#define RESET_HISTORY_SAMPLES 64
+
+int reset_benchmark(int width, int height)
+{
+    Still s(width, height, "gputracer reset benchmark");
+
+    // the edit drags the brush, a small sphere on the ground, a little
+    edit_params before, after;
+    before.t = glm::vec3(1.5f, -0.7f, 3.0f);
+    before.s = glm::vec3(0.3f);
+    before.mat_id = 1;
+    after = before;
+    after.t.x += 0.4f;
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    small_lights_scene(edits);
+    edits.update_brush(after);
+    ComputeShader& prog = s.program(edits);
+
+    reference_image(s, prog, edits, "reference after the edit");
+
+    Vector<glm::vec4>& image = s.image;
+    const char* names[] = { "everything", "covered" };
+    for(int local = 0; local < 2; ++local){
+        edits.update_brush(before);
+        edits.upload();
+        converge(s.b, prog, nullptr, edits, s.textures, nullptr, RESET_HISTORY_SAMPLES, nullptr, 0.0f, image);
+        edits.update_brush(after);
+        edits.upload();
+        // whether the edit resets every pixel
+        const bool all = !local || !s.b.history.reset(edits.uploaded_change().region, s.b.uni.IVP);
+        printf("%-10s: rmse", names[local]);
+        int samples = 0;
+        for(int count = 1; count <= 16; count *= 4){
+            converge(s.b, prog, nullptr, edits, s.textures, nullptr, count - samples, nullptr, 0.0f, image,
+                all ? samples : RESET_HISTORY_SAMPLES + samples);
+            samples = count;
+            printf(" %.5f at %d,", tonemapped_rmse(image, s.reference), count);
+            // pixels reset by the edit are the ones at a sample
+            if(count == 1){
+                int reset = 0;
+                for(int i = 0; i < image.count(); ++i)
+                    reset += image[i].w == 1.0f;
+                printf(" %.1f%% of pixels reset,", 100.0f * reset / image.count());
+            }
+        }
+        printf("\n");
+    }
+    return 0;
+}
+
+int wavefront_benchmark(int width, int height)
+{
+    Bench b(width, height, "gputracer wavefront benchmark");
+    b.history.toggle();
+    Texture4uc textures[MATERIAL_TEXTURE_COUNT];
+    for(int i = 0; i < MATERIAL_TEXTURE_COUNT; ++i){
+        textures[i].init(material_files[i]);
+    }
+    Wavefront wavefront;
+    wavefront.init(width, height, 11, 12);
+    SDF_Programs programs("assets/depth.glsl");
+
+    Vector<glm::vec4> mega, wave;
+    mega.resize(width * height);
+    wave.resize(width * height);
+    const int counts[] = { 1, 32, 256 };
+    for(int count : counts){
+        SDF_Edits edits;
+        edits.init(3, 4, 5);
+        random_scene(edits, count);
+        edits.upload();
+        ComputeShader& prog = programs.select(edits);
+        // leaves the driver's compiles out of the timings
+        converge(b, prog, nullptr, edits, textures, nullptr, 1, nullptr, 0.0f, mega);
+        converge(b, prog, &wavefront, edits, textures, nullptr, 1, nullptr, 0.0f, wave);
+
+        const Convergence m = converge(b, prog, nullptr, edits, textures, nullptr, BENCHMARK_FRAMES, nullptr, 0.0f, mega);
+        const Convergence w = converge(b, prog, &wavefront, edits, textures, nullptr, BENCHMARK_FRAMES, nullptr, 0.0f, wave);
+        printf("%4d edits: megakernel %8.3f ms, wavefront %8.3f ms, %.2fx, image difference %.6f\n", count,
+            m.ms / m.frames, w.ms / w.frames, m.ms / w.ms, tonemapped_error(mega, wave));
+    }
+    return 0;
+}
+
+// ms per frame of depth.glsl, a workgroup per tile or persistent when tiles is set
+static double time_dispatch(Bench& b, ComputeShader& prog, SDF_Edits& edits, TileQueue* tiles)
+{
+    b.emitters.update(edits);
+    auto run = [&](){
+        prog.bind();
+        edits.uniform(prog);
+        b.bricks.uniform(prog, 13);
+        b.cone.uniform(prog);
+        b.lpv.uniform(prog);
+        b.cache.uniform(prog);
+        b.primary.uniform(prog);
+        if(tiles)
+            tiles->dispatch(prog);
+        else
+            prog.call(b.x, b.y, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    };
+    run();
+    glFinish();
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    for(int i = 0; i < BENCHMARK_FRAMES; ++i){
+        run();
+    }
+    glFinish();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / BENCHMARK_FRAMES;
+}
+
+int tile_benchmark(int width, int height)
+{
+    Bench b(width, height, "gputracer tile benchmark");
+    TileQueue tiles;
+    tiles.init(width, height, 14);
+    printf("%u persistent workgroups for %u tiles\n", tiles.group_count(), b.x * b.y);
+
+    SDF_Programs programs("assets/depth.glsl");
+    Vector<glm::vec4> per_tile, persistent;
+    per_tile.resize(width * height);
+    persistent.resize(width * height);
+    const int counts[] = { 32, 256 };
+    for(int count : counts){
+        SDF_Edits edits;
+        edits.init(3, 4, 5);
+        random_scene(edits, count);
+        edits.upload();
+        ComputeShader& prog = programs.specialized(edits);
+        for(int path = 0; path < SUITE_PATHS; ++path){
+            glm::vec3 eye, at;
+            suite_view(path, 0.0f, eye, at);
+            b.uni = view_uniforms(width, height, eye, at);
+            b.unibuf.upload(&b.uni, sizeof(b.uni));
+            printf("%4d edits, %-8s: per tile %8.3f ms", count, suite_paths[path], time_dispatch(b, prog, edits, nullptr));
+            b.history.color().download(per_tile.begin());
+            float difference = 0.0f;
+            for(int order = 0; order < TILE_ORDER_COUNT; ++order){
+                tiles.set_order(order);
+                printf(", %s %8.3f ms", TileQueue::order_name(order), time_dispatch(b, prog, edits, &tiles));
+                b.history.color().download(persistent.begin());
+                difference = glm::max(difference, tonemapped_error(per_tile, persistent));
+            }
+            printf(", image difference %.6f\n", difference);
+        }
+    }
+    return 0;
+}
+
+int cpu_benchmark(int width, int height)
+{
+    SDF_Edits edits;
+    random_scene(edits, 100);
+    Uniforms uni = benchmark_uniforms(width, height);
+
+    const int cores = glm::max(1, int(std::thread::hardware_concurrency()));
+    const int samples = 4;
+    CPUTracer tracer;
+    double single = 0.0;
+    for(int threads = 1; ; threads = glm::min(threads * 2, cores)){
+        tracer.init(width, height, threads);
+        unsigned long long rays = 0;
+        const auto begin = std::chrono::steady_clock::now();
+        for(int i = 0; i < samples; ++i){
+            uni.seed = glm::vec4(0.25f + 0.1f * i, 0.5f, 0.75f, float(i + 1));
+            tracer.render(edits, uni);
+            rays += tracer.last_rays();
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        const double rate = rays / seconds;
+        if(threads == 1)
+            single = rate;
+        printf("%3d threads, %d wide packets: %8.3f Mrays/s, %5.2fx, %3.0f%% per thread\n",
+            threads, SIMD_WIDTH, rate * 1e-6, rate / single, 100.0 * rate / (single * threads));
+        if(threads == cores)
+            break;
+    }
+    write_pfm("cpu.pfm", &tracer.accumulation()->x, width, height);
+    printf("wrote cpu.pfm\n");
+    return 0;
+}
@@ -0,0 +1,84 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// the modes of main, each returns its exit status
+
+// times the edit interpreter against generated programs at 10, 100 and 1000 edits
+int codegen_benchmark(int width, int height);
+
+// checks dual number normals against central differences on the cpu at
+// 100 edits, failing when the 99th percentile angle of any blend type is
+// over a degree; needs no gpu
+int gradient_check(int width, int height);
+
+// gradient_check, then times both normals on the gpu at 100 edits
+int gradient_benchmark(int width, int height);
+
+// checks the brick cache against the committed edits after a full bake,
+// after committing spheres where its cells were empty, after an undo and
+// after 16 commit and undo cycles, with the bricks in use after each
+int brick_benchmark(int width, int height);
+
+// counts primary march steps with and without the cone prepass at 10 and 100 edits
+int cone_benchmark(int width, int height);
+
+// replays fixed camera paths over random scenes of 1, 32, 256 and 4096
+// edits, reports gpu time per pass, rays/s and steps per ray, and writes
+// every run to json for comparing commits
+int suite_benchmark(int width, int height, const char* json);
+
+// accumulates a still view of 32 edits until it is within target of a
+// 256 sample reference, tracing every pixel each frame and then only the
+// pixels adaptive sampling lists, and reports the time each took
+int adaptive_benchmark(int width, int height, float target);
+
+// error against a 256 sample reference at 1 to 64 samples of 32 edits,
+// as accumulated and denoised, and the gpu time of each denoiser pass
+int denoise_benchmark(int width, int height);
+
+// root mean square error against a 1024 sample reference at 1, 4, 16 and
+// 64 samples of 32 edits, drawn from the hash, Sobol and blue noise
+int sequence_benchmark(int width, int height);
+
+// checks the importance sampled brdf against the uniform hemisphere
+// estimator on the cpu, failing before the gpu part when they disagree,
+// then compares their error as sequence_benchmark measures it
+int brdf_benchmark(int width, int height);
+
+// error as sequence_benchmark measures it, of a scene lit by three small
+// lights, with and without sampling the emitters
+int light_benchmark(int width, int height);
+
+// error as sequence_benchmark measures it, of the small lights scene in
+// wood, copper and light, with and without Russian roulette, and the
+// paths/s each traces
+int roulette_benchmark(int width, int height);
+
+// error as sequence_benchmark measures it, of the small lights scene
+// without the radiance cache and with tables of 2^12, 2^15 and 2^18
+// cells, with their occupancy and hit rate
+int cache_benchmark(int width, int height);
+
+// error as sequence_benchmark measures it, time per sample and primary
+// march steps of the small lights scene without and with the primary hit
+// cache
+int primary_benchmark(int width, int height);
+
+// error as sequence_benchmark measures it, at 1, 4 and 16 samples after
+// a small edit to the small lights scene accumulated for 64 samples, when
+// the edit resets the whole image and only the pixels that see it
+int reset_benchmark(int width, int height);
+
+// times the depth.glsl megakernel against the wavefront kernels at 1, 32
+// and 256 edits, and checks both render the same image
+int wavefront_benchmark(int width, int height);
+
+// times depth.glsl with a workgroup per tile against persistent workgroups
+// taking tiles in scanline, Morton and Hilbert order, over the suite's paths
+int tile_benchmark(int width, int height);
+
+// renders 100 edits with the cpu tracer on 1, 2, 4... threads up to every
+// core, reports rays/s and writes the last image to cpu.pfm; needs no gpu
+int cpu_benchmark(int width, int height);
+
+#endif
@@ -0,0 +1,140 @@
+#include "brdf.h"
+
+using namespace glm;
+
+static float DisGGX(const vec3& N, const vec3& H, float roughness){
+    const float a = roughness * roughness;
+    const float a2 = a * a;
+    const float NdH = glm::max(dot(N, H), 0.0f);
+    const float denom_term = NdH * NdH * (a2 - 1.0f) + 1.0f;
+    return a2 / (3.141592f * denom_term * denom_term);
+}
+
+static float GeomSchlickGGX(float NdV, float roughness){
+    const float r = roughness + 1.0f;
+    const float k = (r * r) / 8.0f;
+    return NdV / (NdV * (1.0f - k) + k);
+}
+
+static float GeomSmith(const vec3& N, const vec3& V, const vec3& L, float roughness){
+    const float NdV = glm::max(dot(N, V), 0.0f);
+    const float NdL = glm::max(dot(N, L), 0.0f);
+    return GeomSchlickGGX(NdL, roughness) * GeomSchlickGGX(NdV, roughness);
+}
+
+static vec3 fresnelSchlick(float cosTheta, const vec3& F0){
+    return F0 + (1.0f - F0) * powf(glm::max(1.0f - cosTheta, 0.0f), 5.0f);
+}
+
+vec3 pbr_lighting(const vec3& V, const vec3& L, const vec3& N, const vec3& albedo, float metalness, float roughness){
+    const float NdL = glm::max(0.0f, dot(N, L));
+    const vec3 F0 = mix(vec3(0.04f), albedo, metalness);
+    const vec3 H = normalize(V + L);
+
+    const float NDF = DisGGX(N, H, roughness);
+    const float G = GeomSmith(N, V, L, roughness);
+    const vec3 F = fresnelSchlick(glm::max(dot(H, V), 0.0f), F0);
+
+    const vec3 specular = NDF * G * F / (4.0f * glm::max(dot(N, V), 0.0f) * NdL + 0.001f);
+    const vec3 kD = (vec3(1.0f) - F) * (1.0f - metalness);
+
+    return (kD * albedo / 3.141592f + specular) * NdL;
+}
+
+static mat3 basis(const vec3& N){
+    const float sgn = N.z >= 0.0f ? 1.0f : -1.0f;
+    const float a = -1.0f / (sgn + N.z);
+    const float b = N.x * N.y * a;
+    return mat3(
+        vec3(1.0f + sgn * N.x * N.x * a, sgn * b, -sgn * N.x),
+        vec3(b, sgn + N.y * N.y * a, -N.y),
+        N);
+}
+
+vec3 uniform_hemisphere(const vec3& N, vec2 u){
+    const float r = sqrtf(glm::max(0.0f, 1.0f - u.x * u.x));
+    const float phi = 6.2831853f * u.y;
+    return basis(N) * vec3(r * cosf(phi), r * sinf(phi), u.x);
+}
+
+static float luminance(const vec3& c){
+    return dot(c, vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+static float ggx_D(float NdH, float alpha){
+    const float a2 = alpha * alpha;
+    const float d = NdH * NdH * (a2 - 1.0f) + 1.0f;
+    return a2 / (3.141592f * d * d);
+}
+
+static float ggx_G1(float NdV, float alpha){
+    const float a2 = alpha * alpha;
+    return 2.0f * NdV / (NdV + sqrtf(a2 + (1.0f - a2) * NdV * NdV));
+}
+
+float ggx_alpha(float roughness){
+    return glm::max(roughness * roughness, 0.001f);
+}
+
+float specular_chance(float NdV, const vec3& albedo, float metalness){
+    if(NdV <= 0.0f)
+        return 0.0f;
+    const vec3 F = fresnelSchlick(NdV, mix(vec3(0.04f), albedo, metalness));
+    const float spec = luminance(F);
+    const float diff = luminance((vec3(1.0f) - F) * (1.0f - metalness) * albedo);
+    return clamp(spec / glm::max(spec + diff, 0.0001f), 0.1f, 0.9f);
+}
+
+static vec3 ggx_visible_normal(const vec3& V, float alpha, vec2 u){
+    const vec3 Vh = normalize(vec3(alpha * V.x, alpha * V.y, V.z));
+    const float lensq = Vh.x * Vh.x + Vh.y * Vh.y;
+    const vec3 T1 = lensq > 0.0f ? vec3(-Vh.y, Vh.x, 0.0f) / sqrtf(lensq) : vec3(1.0f, 0.0f, 0.0f);
+    const vec3 T2 = cross(Vh, T1);
+    const float r = sqrtf(u.x);
+    const float phi = 6.2831853f * u.y;
+    const float t1 = r * cosf(phi);
+    const float s = 0.5f * (1.0f + Vh.z);
+    const float t2 = mix(sqrtf(glm::max(0.0f, 1.0f - t1 * t1)), r * sinf(phi), s);
+    const vec3 Nh = t1 * T1 + t2 * T2 + sqrtf(glm::max(0.0f, 1.0f - t1 * t1 - t2 * t2)) * Vh;
+    return normalize(vec3(alpha * Nh.x, alpha * Nh.y, glm::max(0.0f, Nh.z)));
+}
+
+float brdf_pdf(const vec3& V, const vec3& L, const vec3& N, float chance, float alpha){
+    const float NdL = dot(N, L);
+    if(NdL <= 0.0f)
+        return 0.0f;
+    float pdf = (1.0f - chance) * NdL / 3.141592f;
+    if(chance > 0.0f){
+        const vec3 H = normalize(V + L);
+        const float NdV = dot(N, V);
+        pdf += chance * ggx_D(glm::clamp(dot(N, H), 0.0f, 1.0f), alpha) * ggx_G1(NdV, alpha) / (4.0f * NdV);
+    }
+    return pdf;
+}
+
+vec3 sample_brdf(const vec3& V, const vec3& N, const vec3& albedo, float metalness, float roughness,
+    vec2 u, vec3& weight){
+    const mat3 TBN = basis(N);
+    const float chance = specular_chance(dot(N, V), albedo, metalness);
+    const float alpha = ggx_alpha(roughness);
+    vec3 L;
+    if(u.x < chance){
+        u.x /= chance;
+        const vec3 H = TBN * ggx_visible_normal(V * TBN, alpha, u);
+        L = reflect(-V, H);
+    }
+    else{
+        u.x = (u.x - chance) / (1.0f - chance);
+        const float r = sqrtf(u.x);
+        const float phi = 6.2831853f * u.y;
+        L = TBN * vec3(r * cosf(phi), r * sinf(phi), sqrtf(glm::max(0.0f, 1.0f - u.x)));
+    }
+    const float pdf = brdf_pdf(V, L, N, chance, alpha);
+    weight = pdf > 0.0f ? pbr_lighting(V, L, N, albedo, metalness, roughness) / (6.2831853f * pdf) : vec3(0.0f);
+    return L;
+}
+
+float roulette_chance(const vec3& mask, int bounces){
+    const float m = glm::max(mask.x, glm::max(mask.y, mask.z)) * powf(6.2831853f, float(bounces));
+    return m > 0.0f ? glm::clamp(m, 0.05f, 1.0f) : 0.0f;
+}
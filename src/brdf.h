@@ -0,0 +1,25 @@
+#ifndef BRDF_H
+#define BRDF_H
+
+#include "glm/glm.hpp"
+
+/*
+    CPU mirror of the brdf and its sampling in shading.glsl, used by the cpu
+    tracer and checked against the uniform hemisphere estimator by
+    brdf_benchmark. u is a pair of uniform numbers in [0, 1).
+*/
+glm::vec3 pbr_lighting(const glm::vec3& V, const glm::vec3& L, const glm::vec3& N, const glm::vec3& albedo, float metalness, float roughness);
+// uniform over the hemisphere around N
+glm::vec3 uniform_hemisphere(const glm::vec3& N, glm::vec2 u);
+float ggx_alpha(float roughness);
+float specular_chance(float NdV, const glm::vec3& albedo, float metalness);
+// density of L among the directions sample_brdf picks
+float brdf_pdf(const glm::vec3& V, const glm::vec3& L, const glm::vec3& N, float chance, float alpha);
+// next direction of a path leaving N towards V, its throughput in weight,
+// on the 1 / 2pi scale of the uniform estimator
+glm::vec3 sample_brdf(const glm::vec3& V, const glm::vec3& N, const glm::vec3& albedo, float metalness, float roughness,
+    glm::vec2 u, glm::vec3& weight);
+// chance Russian roulette keeps a path of throughput mask after bounces
+float roulette_chance(const glm::vec3& mask, int bounces);
+
+#endif
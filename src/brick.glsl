@@ -0,0 +1,30 @@
+// Sparse brick cache of the committed edits: a top level grid whose cells
+// are either empty, holding the distance at their centre, or point at a
+// brick of BRICK_SAMPLES^3 distance and edit id samples in the atlas.
+
+#define BRICK_SAMPLES 8
+#define BRICK_ATLAS_DIM 32   // bricks along x and y of the atlas
+#define BRICK_ATLAS_LAYERS 16 // bricks along z
+#define BRICK_CAPACITY (BRICK_ATLAS_DIM * BRICK_ATLAS_DIM * BRICK_ATLAS_LAYERS)
+#define BRICK_EMPTY -1
+#define BRICK_LIVE -2
+#define BRICK_WANT -3 // between brick_alloc and brick_claim only
+
+uniform vec4 brick_origin; // xyz: grid min, w: world size of a cell
+uniform ivec3 brick_dims;
+
+ivec3 brick_atlas_offset(int brick){
+    return BRICK_SAMPLES * ivec3(
+        brick % BRICK_ATLAS_DIM,
+        (brick / BRICK_ATLAS_DIM) % BRICK_ATLAS_DIM,
+        brick / (BRICK_ATLAS_DIM * BRICK_ATLAS_DIM));
+}
+
+vec3 brick_cell_center(ivec3 cell){
+    return brick_origin.xyz + (vec3(cell) + 0.5) * brick_origin.w;
+}
+
+// samples sit on the cell's corners and faces so neighbouring bricks agree
+vec3 brick_sample_position(ivec3 cell, ivec3 s){
+    return brick_origin.xyz + (vec3(cell) + vec3(s) / float(BRICK_SAMPLES - 1)) * brick_origin.w;
+}
@@ -0,0 +1,55 @@
+#version 430 core
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+#include "sdf.glsl"
+#include "brick.glsl"
+
+layout(binding = 1, rg32f) uniform image3D brick_grid;
+
+layout(std430, binding=6) buffer BRICK_COUNT_BUF {
+    uint fill_groups_x; // indirect dispatch of brick_fill, one group per queued brick
+    uint fill_groups_y;
+    uint fill_groups_z;
+    uint brick_count;    // bricks handed out of the atlas
+    uint brick_overflow; // non-zero once a cell found no brick
+    uint free_count;
+    uint brick_free[];   // bricks no cell holds, below brick_count
+};
+
+layout(std430, binding=7) buffer BRICK_FILL_BUF {
+    ivec4 brick_fills[]; // xyz: cell, w: brick
+};
+
+uniform ivec3 brick_cell_lo; // first and last cell of the region being rebaked
+uniform ivec3 brick_cell_hi;
+uniform int brick_reset;     // non-zero to drop every existing brick
+
+// one invocation per cell of the region; cells that need a new brick are
+// left wanting one for brick_claim, so the bricks freed here can be reused
+void main(){
+    const ivec3 cell = brick_cell_lo + ivec3(gl_GlobalInvocationID.xyz);
+    if(any(greaterThan(cell, brick_cell_hi)))
+        return;
+
+    // the brush is evaluated live, so only the committed edits are cached
+    const vec3 q = brick_cell_center(cell);
+    const float d = sdf_map_first(q, num_sdfs - 1).x;
+
+    // cells that can hold a point within one sample spacing of the surface
+    // get a brick, so filtering and normals near the surface stay in bricks
+    const float reach = brick_origin.w * (0.8660254 + 1.0 / float(BRICK_SAMPLES - 1));
+    const bool near = abs(d) <= reach;
+    int brick = brick_reset != 0 ? BRICK_EMPTY : int(imageLoad(brick_grid, cell).y);
+    if(brick >= 0 && !near){
+        brick_free[atomicAdd(free_count, 1u)] = uint(brick);
+        brick = BRICK_EMPTY;
+    }
+    else if(brick < 0){
+        brick = near ? BRICK_WANT : BRICK_EMPTY;
+    }
+    if(brick >= 0){
+        brick_fills[atomicAdd(fill_groups_x, 1u)] = ivec4(cell, brick);
+    }
+    imageStore(brick_grid, cell, vec4(d, float(brick), 0.0, 0.0));
+}
@@ -0,0 +1,51 @@
+#version 430 core
+
+// Compares the brick cache of brickmap.h with what baking the committed
+// edits now would give, at a lattice of points over its grid, for main
+// bricks. Neither an empty cell's distance at its centre nor a brick's at
+// the point should be larger than the field they are baked from has there,
+// within a sample spacing; more is a cell left stale by an edit, which a
+// march could step through the surface from.
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+#include "scene.glsl"
+
+layout(std430, binding = 8) buffer BRICK_CHECK_BUF
+{
+    uint checked;
+    uint over;      // points whose cell overestimates
+    uint worst;     // largest overestimate as float bits
+    uint unused;
+};
+
+// box the lattice spans, and points along each axis
+uniform vec3 check_lo;
+uniform vec3 check_hi;
+uniform int check_points;
+
+void main(){
+    const ivec3 i = ivec3(gl_GlobalInvocationID.xyz);
+    if(any(greaterThanEqual(i, ivec3(check_points))))
+        return;
+    // off the brick samples, which the cache matches by construction
+    const vec3 p = mix(check_lo, check_hi, (vec3(i) + 0.37) / float(check_points));
+    const ivec3 cell = ivec3(floor((p - brick_origin.xyz) / brick_origin.w));
+    if(any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(cell, brick_dims)))
+        return;
+    const vec2 c = imageLoad(brick_grid, cell).xy;
+    if(int(c.y) == BRICK_LIVE)
+        return;
+    atomicAdd(checked, 1u);
+
+    const bool empty = int(c.y) == BRICK_EMPTY;
+    const vec3 q = empty ? brick_cell_center(cell) : p;
+    const float cached = empty ? c.x : brick_map(p).x;
+    const float exact = sdf_map_committed(q).x;
+    // inside the edits the bounds hold the other way
+    const float e = exact >= 0.0 ? cached - exact : exact - cached;
+    if(e > brick_origin.w / float(BRICK_SAMPLES - 1)){
+        atomicAdd(over, 1u);
+        atomicMax(worst, floatBitsToUint(e));
+    }
+}
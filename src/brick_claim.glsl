@@ -0,0 +1,77 @@
+#version 430 core
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+#include "brick.glsl"
+
+layout(binding = 1, rg32f) uniform image3D brick_grid;
+
+layout(std430, binding=6) buffer BRICK_COUNT_BUF {
+    uint fill_groups_x; // indirect dispatch of brick_fill, one group per queued brick
+    uint fill_groups_y;
+    uint fill_groups_z;
+    uint brick_count;    // bricks handed out of the atlas
+    uint brick_overflow; // non-zero once a cell found no brick
+    uint free_count;
+    uint brick_free[];   // bricks no cell holds, below brick_count
+};
+
+layout(std430, binding=7) buffer BRICK_FILL_BUF {
+    ivec4 brick_fills[]; // xyz: cell, w: brick
+};
+
+uniform ivec3 brick_cell_lo; // first and last cell of the region being rebaked
+uniform ivec3 brick_cell_hi;
+// region the committed edits changed; outside it they are no nearer than
+// slope times the distance to it plus offset, which bounds the cells
+// outside the rebaked one
+uniform vec3 brick_change_lo;
+uniform vec3 brick_change_hi;
+uniform float brick_change_slope;
+uniform float brick_change_offset;
+
+// a freed brick, or -1 when there are none left; only ever runs after
+// brick_alloc has pushed every brick it frees
+int brick_pop(){
+    uint n = free_count;
+    while(n > 0u){
+        const uint m = atomicCompSwap(free_count, n, n - 1u);
+        if(m == n)
+            return int(brick_free[n - 1u]);
+        n = m;
+    }
+    return -1;
+}
+
+// Second pass of a bake, over the whole grid and without evaluating any
+// edit: cells brick_alloc left wanting a brick take one, freed ones first,
+// and empty cells outside the rebaked region bound their distance.
+void main(){
+    const ivec3 cell = ivec3(gl_GlobalInvocationID.xyz);
+    if(any(greaterThanEqual(cell, brick_dims)))
+        return;
+    const vec2 c = imageLoad(brick_grid, cell).xy;
+    if(any(lessThan(cell, brick_cell_lo)) || any(greaterThan(cell, brick_cell_hi))){
+        // an empty cell's centre distance can be no larger than the
+        // changed edits' bound there
+        const vec3 q = brick_cell_center(cell);
+        const float d = length(max(max(brick_change_lo - q, q - brick_change_hi), 0.0));
+        const float reach = max(brick_change_slope * d + brick_change_offset, 0.0);
+        if(int(c.y) == BRICK_EMPTY && abs(c.x) > reach)
+            imageStore(brick_grid, cell, vec4(sign(c.x) * reach, c.y, 0.0, 0.0));
+        return;
+    }
+    if(int(c.y) != BRICK_WANT)
+        return;
+
+    int brick = brick_pop();
+    if(brick < 0){
+        const uint i = atomicAdd(brick_count, 1u);
+        brick = i < uint(BRICK_CAPACITY) ? int(i) : BRICK_LIVE;
+    }
+    if(brick >= 0)
+        brick_fills[atomicAdd(fill_groups_x, 1u)] = ivec4(cell, brick);
+    else
+        brick_overflow = 1u;
+    imageStore(brick_grid, cell, vec4(c.x, float(brick), 0.0, 0.0));
+}
@@ -0,0 +1,23 @@
+#version 430 core
+
+#include "sdf.glsl"
+#include "brick.glsl"
+
+layout(local_size_x = BRICK_SAMPLES, local_size_y = BRICK_SAMPLES, local_size_z = BRICK_SAMPLES) in;
+
+layout(binding = 2, r32i) uniform writeonly iimage3D brick_ids;
+layout(binding = 3, r32f) uniform writeonly image3D brick_distances;
+
+layout(std430, binding=7) buffer BRICK_FILL_BUF {
+    ivec4 brick_fills[]; // xyz: cell, w: brick
+};
+
+// one work group per brick queued by brick_alloc
+void main(){
+    const ivec4 fill = brick_fills[gl_WorkGroupID.x];
+    const ivec3 s = ivec3(gl_LocalInvocationID.xyz);
+    const vec2 sam = sdf_map_first(brick_sample_position(fill.xyz, s), num_sdfs - 1);
+    const ivec3 texel = brick_atlas_offset(fill.w) + s;
+    imageStore(brick_distances, texel, vec4(sam.x));
+    imageStore(brick_ids, texel, ivec4(int(sam.y)));
+}
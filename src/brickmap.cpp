@@ -0,0 +1,174 @@
+#include "brickmap.h"
+#include "sdf.h"
+#include "myglheaders.h"
+#include "debugmacro.h"
+#include <cstddef>
+
+using namespace glm;
+
+// the head of BRICK_COUNT_BUF, the free list follows
+struct BrickCounts{
+    unsigned fill_groups[3];
+    unsigned brick_count;
+    unsigned overflow;
+    unsigned free_count;
+};
+
+BrickMap::BrickMap()
+    : alloc("assets/brick_alloc.glsl"), claim("assets/brick_claim.glsl"), fill("assets/brick_fill.glsl"),
+    origin(0.0f), dims(0), grid_image(0), fence(nullptr), enabled(false), dirty(true){
+}
+
+BrickMap::~BrickMap(){
+    if(fence)
+        glDeleteSync((GLsync)fence);
+}
+
+void BrickMap::init(unsigned grid_img, unsigned id_img, unsigned distance_img, unsigned count_binding, unsigned fill_binding){
+    const int atlas = BRICK_ATLAS_DIM * BRICK_SAMPLES;
+    const int layers = BRICK_ATLAS_LAYERS * BRICK_SAMPLES;
+    distances.init(atlas, atlas, layers, true);
+    distances.setCSBinding(distance_img, GL_READ_WRITE);
+    ids.init(atlas, atlas, layers);
+    ids.setCSBinding(id_img, GL_READ_WRITE);
+    grid_image = grid_img;
+    grid.init(1, 1, 1);
+    grid.setCSBinding(grid_image, GL_READ_WRITE);
+
+    BrickCounts counts = {{0, 1, 1}, 0, 0, 0};
+    count_ssbo.init(nullptr, 0, count_binding);
+    count_ssbo.upload(nullptr, sizeof(counts) + BRICK_CAPACITY * sizeof(unsigned));
+    count_ssbo.update(&counts, sizeof(counts));
+    fill_ssbo.init(nullptr, 0, fill_binding);
+    fill_ssbo.upload(nullptr, BRICK_CAPACITY * sizeof(ivec4));
+}
+
+void BrickMap::uniforms(ComputeShader& shader){
+    shader.setUniform("brick_origin", origin);
+    shader.setUniform("brick_dims", dims);
+}
+
+// the outer layer of cells only exists to hold bricks for surfaces near the edge
+bool BrickMap::covers(const AABB& box)const{
+    if(dims.x == 0)
+        return false;
+    const vec3 lo = vec3(origin) + origin.w;
+    const vec3 hi = vec3(origin) + vec3(dims - 1) * origin.w;
+    return all(greaterThanEqual(box.lo, lo)) && all(lessThanEqual(box.hi, hi));
+}
+
+void BrickMap::place(const AABB& box){
+    const vec3 e = box.extent() * 2.0f;
+    const float size = glm::max(BRICK_MIN_SIZE, glm::max(e.x, glm::max(e.y, e.z)) / float(BRICK_GRID_MAX - 2));
+    const ivec3 new_dims = glm::min(ivec3(ceil(e / size)) + 2, ivec3(BRICK_GRID_MAX));
+    origin = vec4(box.center() - vec3(new_dims) * size * 0.5f, size);
+    if(new_dims != dims){
+        dims = new_dims;
+        grid.init(dims.x, dims.y, dims.z);
+        grid.setCSBinding(grid_image, GL_READ_WRITE);
+    }
+}
+
+void BrickMap::bake(SDF_Edits& edits, const ivec3& lo, const ivec3& hi, const SDF_Change& change, bool reset){
+    // a full bake starts the atlas and the free list over
+    BrickCounts counts = {{0, 1, 1}, 0, 0, 0};
+    if(reset)
+        count_ssbo.update(&counts, sizeof(counts));
+    else
+        count_ssbo.update(&counts, sizeof(counts.fill_groups));
+
+    const ivec3 cells = hi - lo + 1;
+    alloc.bind();
+    edits.uniform(alloc);
+    uniforms(alloc);
+    alloc.setUniform("brick_cell_lo", lo);
+    alloc.setUniform("brick_cell_hi", hi);
+    alloc.setUniformInt("brick_reset", reset ? 1 : 0);
+    alloc.call((cells.x + 3) / 4, (cells.y + 3) / 4, (cells.z + 3) / 4);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+    // every cell, those outside lo to hi only clamp their distance
+    claim.bind();
+    uniforms(claim);
+    claim.setUniform("brick_cell_lo", lo);
+    claim.setUniform("brick_cell_hi", hi);
+    claim.setUniform("brick_change_lo", change.region.lo);
+    claim.setUniform("brick_change_hi", change.region.hi);
+    claim.setUniformFloat("brick_change_slope", change.slope);
+    claim.setUniformFloat("brick_change_offset", change.offset);
+    claim.call((dims.x + 3) / 4, (dims.y + 3) / 4, (dims.z + 3) / 4);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+    fill.bind();
+    edits.uniform(fill);
+    uniforms(fill);
+    fill.callIndirect(count_ssbo.handle());
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+}
+
+// reads the overflow flag of the last incremental bake once the gpu is past it
+void BrickMap::poll(){
+    if(!fence || glClientWaitSync((GLsync)fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        return;
+    glDeleteSync((GLsync)fence);
+    fence = nullptr;
+    unsigned overflow = 0;
+    count_ssbo.read(&overflow, sizeof(overflow), offsetof(BrickCounts, overflow));
+    dirty = dirty || overflow != 0;
+}
+
+void BrickMap::update(SDF_Edits& edits){
+    poll();
+    const SDF_Change& change = edits.committed_change();
+    if(!enabled || (!dirty && change.empty()))
+        return;
+
+    const AABB box = edits.committed_bounds();
+    if(dirty || change.everywhere || !covers(box)){
+        // cells it leaves without a brick stay live, nothing to read back
+        if(fence){
+            glDeleteSync((GLsync)fence);
+            fence = nullptr;
+        }
+        if(box.empty()){
+            dims = ivec3(0);
+        }
+        else{
+            place(box);
+            bake(edits, ivec3(0), dims - 1, change, true);
+        }
+    }
+    else{
+        // brick samples lie within BRICK_REACH cells of the surface, so
+        // past where the changed edits' bound reaches that they can not
+        // bring it any closer to them
+        const AABB region = change.region.expanded((BRICK_REACH * origin.w - change.offset) / change.slope);
+        const vec3 lo = (region.lo - vec3(origin)) / origin.w;
+        const vec3 hi = (region.hi - vec3(origin)) / origin.w;
+        const ivec3 first = glm::max(ivec3(floor(lo)), ivec3(0));
+        const ivec3 last = glm::min(ivec3(floor(hi)), dims - 1);
+        if(all(lessThanEqual(first, last))){
+            bake(edits, first, last, change, false);
+            glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+            if(fence)
+                glDeleteSync((GLsync)fence);
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+    }
+
+    edits.clear_committed_change();
+    dirty = false;
+}
+
+void BrickMap::uniform(ComputeShader& shader, int distance_unit){
+    shader.setUniformInt("brick_enabled", enabled ? 1 : 0);
+    uniforms(shader);
+    distances.bind(distance_unit, "brick_distances", shader);
+}
+
+unsigned BrickMap::bricks_used(){
+    BrickCounts counts;
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    count_ssbo.read(&counts, sizeof(counts));
+    return glm::min(counts.brick_count, unsigned(BRICK_CAPACITY)) - counts.free_count;
+}
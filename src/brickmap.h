@@ -0,0 +1,64 @@
+#ifndef BRICKMAP_H
+#define BRICKMAP_H
+
+#include "glm/glm.hpp"
+#include "compute_shader.h"
+#include "texture.h"
+#include "SSBO.h"
+#include "aabb.h"
+
+class SDF_Edits;
+struct SDF_Change;
+
+// must match brick.glsl
+#define BRICK_SAMPLES 8
+#define BRICK_ATLAS_DIM 32   // bricks along x and y of the atlas
+#define BRICK_ATLAS_LAYERS 16 // bricks along z
+#define BRICK_CAPACITY (BRICK_ATLAS_DIM * BRICK_ATLAS_DIM * BRICK_ATLAS_LAYERS)
+#define BRICK_GRID_MAX 64
+#define BRICK_MIN_SIZE 0.05f
+// cells from the surface a brick sample can be, a cell's half diagonal
+// past the reach that gives it a brick in brick_alloc.glsl
+#define BRICK_REACH 2.0f
+
+/*
+    Sparse distance cache of every edit but the brush. A coarse grid over the
+    committed edits' bounds marks the cells near the surface, which get a
+    brick of BRICK_SAMPLES^3 samples in a shared atlas; the rest only keep
+    the distance at their centre. Committing or undoing an edit only rebakes
+    the cells its distance bound comes within BRICK_REACH cells of and
+    bounds the centre distance of the other empty cells by it, while the brush stays
+    live on top. Bricks cells no longer need go on a free list for the next
+    edits. Only once the atlas runs out, which the gpu flags and an update
+    reads after the bake's fence has passed, is everything rebaked.
+*/
+class BrickMap{
+    ComputeShader alloc, claim, fill;
+    Texture3D2f grid;      // r: distance at cell centre, g: brick index or BRICK_EMPTY/BRICK_LIVE
+    Texture3D1f distances;
+    Texture3D1i ids;
+    SSBO count_ssbo, fill_ssbo;
+    glm::vec4 origin;      // xyz: grid min, w: world size of a cell
+    glm::ivec3 dims;
+    unsigned grid_image;
+    void* fence;           // after the last incremental bake, until its overflow flag is read
+    bool enabled, dirty;
+    void uniforms(ComputeShader& shader);
+    bool covers(const AABB& box)const;
+    void place(const AABB& box);
+    void bake(SDF_Edits& edits, const glm::ivec3& lo, const glm::ivec3& hi, const SDF_Change& change, bool reset);
+    void poll();
+public:
+    BrickMap();
+    ~BrickMap();
+    void init(unsigned grid_img, unsigned id_img, unsigned distance_img, unsigned count_binding, unsigned fill_binding);
+    inline void toggle(){ enabled = !enabled; dirty = true; }
+    inline bool on()const{ return enabled; }
+    // rebakes what the committed edits changed, call after SDF_Edits::upload
+    void update(SDF_Edits& edits);
+    void uniform(ComputeShader& shader, int distance_unit);
+    // bricks cells hold, read back from the gpu
+    unsigned bricks_used();
+};
+
+#endif
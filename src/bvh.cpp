@@ -0,0 +1,130 @@
+#include "bvh.h"
+#include "sdf.h"
+#include "compute_shader.h"
+#include <algorithm>
+
+using namespace glm;
+
+static void leaf_bounds(const SDF& sdf, AABB& box, float& offset, float& slope){
+    box = sdf.influence();
+    // only unions are merged as a bound, the rest are left out of it
+    slope = sdf.additive() ? sdf.bound_slope() : 0.0f;
+    offset = sdf.additive() ? sdf.bound_offset() : 0.0f;
+}
+
+// the smaller slope and offset of the children that hold additive edits
+static void combine_bounds(const BVHNode& l, const BVHNode& r, float& offset, float& slope){
+    if(l.hi.w <= 0.0f || r.hi.w <= 0.0f){
+        const BVHNode& n = l.hi.w > 0.0f ? l : r;
+        offset = n.lo.w;
+        slope = n.hi.w;
+        return;
+    }
+    offset = glm::min(l.lo.w, r.lo.w);
+    slope = glm::min(l.hi.w, r.hi.w);
+}
+
+void SDF_BVH::init(unsigned node_binding, unsigned unbounded_binding){
+    node_ssbo.init(nullptr, 0, node_binding);
+    unbounded_ssbo.init(nullptr, 0, unbounded_binding);
+}
+
+void SDF_BVH::fit(int idx){
+    BVHNode& node = nodes[idx];
+    const BVHNode& l = nodes[node.link.x];
+    const BVHNode& r = nodes[node.link.y];
+    float offset, slope;
+    combine_bounds(l, r, offset, slope);
+    node.lo = vec4(glm::min(vec3(l.lo), vec3(r.lo)), offset);
+    node.hi = vec4(glm::max(vec3(l.hi), vec3(r.hi)), slope);
+}
+
+int SDF_BVH::build(int* items, int count, const AABB* boxes, const glm::vec2* offsets, int parent){
+    const int idx = nodes.count();
+    {
+        BVHNode& node = nodes.grow();
+        node.link = ivec4(-1, -1, -1, parent);
+        if(count == 1){
+            const int edit = items[0];
+            node.lo = vec4(boxes[edit].lo, offsets[edit].x);
+            node.hi = vec4(boxes[edit].hi, offsets[edit].y);
+            node.link.z = edit;
+            leaves[edit] = idx;
+            return idx;
+        }
+    }
+
+    AABB centroids;
+    for(int i = 0; i < count; ++i){
+        centroids.grow(boxes[items[i]].center());
+    }
+    const vec3 e = centroids.extent();
+    const int axis = (e.x >= e.y && e.x >= e.z) ? 0 : (e.y >= e.z ? 1 : 2);
+
+    // median split keeps the depth at log2(count), which bounds the shader's stack
+    const int half = count / 2;
+    std::nth_element(items, items + half, items + count, [&](int a, int b){
+        return boxes[a].center()[axis] < boxes[b].center()[axis];
+    });
+
+    const int left = build(items, half, boxes, offsets, idx);
+    const int right = build(items + half, count - half, boxes, offsets, idx);
+    nodes[idx].link.x = left;
+    nodes[idx].link.y = right;
+    fit(idx);
+    return idx;
+}
+
+void SDF_BVH::build(const SDF* sdfs, int count){
+    nodes.clear();
+    unbounded.clear();
+    leaves.clear();
+
+    Vector<int> items(count);
+    Vector<AABB> boxes(count);
+    Vector<vec2> offsets(count);
+    for(int i = 0; i < count; ++i){
+        leaves.grow() = -1;
+        vec2& offset = offsets.append();
+        leaf_bounds(sdfs[i], boxes.append(), offset.x, offset.y);
+        if(sdfs[i].bounded())
+            items.append() = i;
+        else
+            unbounded.grow() = i;
+    }
+
+    if(items.count())
+        build(items.begin(), items.count(), boxes.begin(), offsets.begin(), -1);
+}
+
+bool SDF_BVH::refit(const SDF* sdfs, int count, int edit){
+    if(count != leaves.count())
+        return false;
+
+    const SDF& sdf = sdfs[edit];
+    const int leaf = leaves[edit];
+    if(leaf < 0)
+        return !sdf.bounded();
+    if(!sdf.bounded() || (nodes[leaf].hi.w > 0.0f) != sdf.additive())
+        return false;
+
+    AABB box;
+    float offset, slope;
+    leaf_bounds(sdf, box, offset, slope);
+    nodes[leaf].lo = vec4(box.lo, offset);
+    nodes[leaf].hi = vec4(box.hi, slope);
+    for(int i = nodes[leaf].link.w; i != -1; i = nodes[i].link.w){
+        fit(i);
+    }
+    return true;
+}
+
+void SDF_BVH::upload(){
+    node_ssbo.upload(nodes.begin(), nodes.bytes());
+    unbounded_ssbo.upload(unbounded.begin(), unbounded.bytes());
+}
+
+void SDF_BVH::uniform(ComputeShader& shader){
+    shader.setUniformInt("num_bvh_nodes", nodes.count());
+    shader.setUniformInt("num_sdf_unbounded", unbounded.count());
+}
@@ -0,0 +1,45 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "glm/glm.hpp"
+#include "array.h"
+#include "aabb.h"
+#include "SSBO.h"
+
+class SDF;
+class ComputeShader;
+
+// padding added to every edit's box so culled edits never register a hit
+#define SDF_BVH_MARGIN 0.01f
+
+struct BVHNode{
+    glm::vec4 lo;    // xyz: padded min, w: distance offset of culled additive edits
+    glm::vec4 hi;    // xyz: padded max, w: their distance slope, 0 if none
+    glm::ivec4 link; // [left, right, edit index or -1, parent]
+};
+
+/*
+    Bounding volume hierarchy over the edit list. Leaves hold one edit each;
+    the shader gathers the leaves containing a point and folds them in edit
+    order, so the non-commutative blends still apply in sequence. Culled
+    additive edits contribute a lower bound on their distance instead.
+    Edits without finite bounds live in a separate list and are always
+    evaluated.
+*/
+class SDF_BVH{
+    Vector<BVHNode> nodes;
+    Vector<int> unbounded;
+    Vector<int> leaves; // edit index -> leaf node, -1 if unbounded
+    SSBO node_ssbo, unbounded_ssbo;
+    int build(int* items, int count, const AABB* boxes, const glm::vec2* offsets, int parent);
+    void fit(int node);
+public:
+    void init(unsigned node_binding, unsigned unbounded_binding);
+    void build(const SDF* sdfs, int count);
+    // updates one edit's leaf and its ancestors, false if a rebuild is needed
+    bool refit(const SDF* sdfs, int count, int edit);
+    void upload();
+    void uniform(ComputeShader& shader);
+};
+
+#endif
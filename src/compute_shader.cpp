@@ -6,31 +6,84 @@
 #include <algorithm>
 #include "glm/gtc/type_ptr.hpp"
 
-ComputeShader::ComputeShader(const std::string& filename){
-    progid = glCreateProgram();
-    MYGLERRORMACRO
-    shaderid = glCreateShader(GL_COMPUTE_SHADER);
-    MYGLERRORMACRO
-    
-    std::string source;
+// splices in lines of the form #include "file", relative to the including file.
+// An include matching generated is replaced by generated_source instead.
+static bool loadSource(const std::string& filename, std::string& source,
+    const std::string& generated = "", const std::string& generated_source = ""){
     std::ifstream stream(filename);
     if(!stream.is_open()){
         printf("Could not open compute shader source %s\n", filename.c_str());
-        return;
+        return false;
     }
     
+    const std::string directive = "#include \"";
+    const size_t slash = filename.find_last_of("/\\");
+    const std::string dir = slash == std::string::npos ? "" : filename.substr(0, slash + 1);
     std::string line;
-    while(getline(stream, line))
+    while(getline(stream, line)){
+        if(line.compare(0, directive.size(), directive) == 0){
+            const size_t end = line.find('"', directive.size());
+            const std::string file = line.substr(directive.size(), end - directive.size());
+            if(!generated.empty() && file == generated){
+                source += generated_source;
+                continue;
+            }
+            if(!loadSource(dir + file, source, generated, generated_source))
+                return false;
+            continue;
+        }
         source += line + "\n";
+    }
+    return true;
+}
+
+ComputeShader::ComputeShader(const std::string& filename) : status(FAILED){
+    progid = glCreateProgram();
+    MYGLERRORMACRO
+    shaderid = glCreateShader(GL_COMPUTE_SHADER);
+    MYGLERRORMACRO
     
+    std::string source;
+    if(!loadSource(filename, source))
+        return;
+    
+    compile(source);
+    check();
+}
+
+ComputeShader::ComputeShader(const std::string& filename, const std::string& generated, const std::string& generated_source, bool async)
+    : status(FAILED){
+    progid = glCreateProgram();
+    MYGLERRORMACRO
+    shaderid = glCreateShader(GL_COMPUTE_SHADER);
+    MYGLERRORMACRO
+
+    std::string source;
+    if(!loadSource(filename, source, generated, generated_source))
+        return;
+
+    compile(source);
+    if(!async)
+        check();
+}
+
+void ComputeShader::compile(const std::string& source){
     char const* src_pointer = source.c_str();
     glShaderSource(shaderid, 1, &src_pointer, NULL);
     MYGLERRORMACRO
-    
-    GLint result = GL_FALSE;
-    int infoLogLength;
     glCompileShader(shaderid);
     MYGLERRORMACRO
+    glAttachShader(progid, shaderid);
+    MYGLERRORMACRO
+    glLinkProgram(progid);
+    MYGLERRORMACRO
+    status = COMPILING;
+}
+
+// blocks until the driver is done with the program
+void ComputeShader::check(){
+    GLint result = GL_FALSE;
+    int infoLogLength;
     glGetShaderiv(shaderid, GL_COMPILE_STATUS, &result);
     MYGLERRORMACRO
     if(!result){
@@ -42,15 +95,9 @@ ComputeShader::ComputeShader(const std::string& filename){
         fprintf(stdout, "%s\n", &shaderErrorMessage[0]);
         glDeleteShader(shaderid);
         MYGLERRORMACRO
-        glDeleteProgram(progid);
-        MYGLERRORMACRO
+        status = FAILED;
         return;
     }
-    
-    glAttachShader(progid, shaderid);
-    MYGLERRORMACRO
-    glLinkProgram(progid);
-    MYGLERRORMACRO
     glDeleteShader(shaderid);
     MYGLERRORMACRO
     
@@ -64,13 +111,27 @@ ComputeShader::ComputeShader(const std::string& filename){
         glGetProgramInfoLog(progid, infoLogLength, NULL, &shaderErrorMessage[0]);
         MYGLERRORMACRO
         fprintf(stdout, "%s\n", &shaderErrorMessage[0]);
-        glDeleteProgram(progid);
-        MYGLERRORMACRO
+        status = FAILED;
         return;
     }
     
-    MYGLERRORMACRO
+    status = LINKED;
+}
+
+bool ComputeShader::ready(){
+    if(status == COMPILING){
+        if(GLEW_ARB_parallel_shader_compile){
+            GLint done = GL_FALSE;
+            glGetProgramiv(progid, GL_COMPLETION_STATUS_ARB, &done);
+            MYGLERRORMACRO
+            if(!done)
+                return false;
+        }
+        check();
+    }
+    return status == LINKED;
 }
+
 ComputeShader::~ComputeShader(){
     glDeleteProgram(progid);
     MYGLERRORMACRO
@@ -84,6 +145,13 @@ void ComputeShader::call(unsigned x, unsigned y, unsigned z){
     MYGLERRORMACRO
 }
 
+void ComputeShader::callIndirect(unsigned buffer, size_t offset){
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, buffer);
+    MYGLERRORMACRO
+    glDispatchComputeIndirect(offset);
+    MYGLERRORMACRO
+}
+
 int ComputeShader::getUniformLocation(const std::string& name){
     auto iter = uniforms.find(name);
     if(iter == end(uniforms)){
@@ -130,6 +198,13 @@ void ComputeShader::setUniform(const std::string& name, const glm::mat4& v){
     glUniformMatrix4fv(location, 1, false, glm::value_ptr(v));
     MYGLERRORMACRO
 }
+void ComputeShader::setUniform(const std::string& name, const glm::ivec3& v){
+    const int location = getUniformLocation(name);
+    if (location == -1)
+        return;
+    glUniform3iv(location, 1, glm::value_ptr(v));
+    MYGLERRORMACRO
+}
 void ComputeShader::setUniformInt(const std::string& name, const int v){
     const int location = getUniformLocation(name);
     if (location == -1)
@@ -6,19 +6,31 @@
 #include "glm/glm.hpp"
 
 class ComputeShader{
+    enum Status{ COMPILING, LINKED, FAILED };
     unsigned progid, shaderid;
+    Status status;
     std::unordered_map<std::string, int> uniforms;
     int getUniformLocation(const std::string& name);
+    void compile(const std::string& source);
+    void check();
 public:
     ComputeShader(const std::string& filename);
+    // filename with the include named generated replaced by generated_source;
+    // async leaves linking to the driver's compiler threads, see ready()
+    ComputeShader(const std::string& filename, const std::string& generated, const std::string& generated_source, bool async);
     ~ComputeShader();
+    // false while an async compile is running or if it failed
+    bool ready();
     void bind();
     void call(unsigned x, unsigned y, unsigned z);
+    // work group counts are read from three uints at offset in buffer
+    void callIndirect(unsigned buffer, size_t offset=0);
     void setUniform(const std::string& name, const glm::vec2& v);
     void setUniform(const std::string& name, const glm::vec3& v);
     void setUniform(const std::string& name, const glm::vec4& v);
     void setUniform(const std::string& name, const glm::mat3& v);
     void setUniform(const std::string& name, const glm::mat4& v);
+    void setUniform(const std::string& name, const glm::ivec3& v);
     void setUniformInt(const std::string& name, const int v);
     void setUniformFloat(const std::string& name, const float v);
 };
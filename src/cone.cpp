@@ -0,0 +1,24 @@
+#include "cone.h"
+#include "sdf.h"
+#include "brickmap.h"
+
+void ConePrepass::init(int screen_width, int screen_height, unsigned image){
+    width = (screen_width + CONE_TILE - 1) / CONE_TILE;
+    height = (screen_height + CONE_TILE - 1) / CONE_TILE;
+    depths.init(width, height);
+    depths.setCSBinding(image, GL_READ_WRITE);
+}
+
+void ConePrepass::run(ComputeShader& prog, SDF_Edits& edits, BrickMap& bricks, int distance_unit){
+    if(!enabled)
+        return;
+    prog.bind();
+    edits.uniform(prog);
+    bricks.uniform(prog, distance_unit);
+    prog.call((width + 7) / 8, (height + 7) / 8, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
+
+void ConePrepass::uniform(ComputeShader& shader){
+    shader.setUniformInt("cone_enabled", enabled ? 1 : 0);
+}
@@ -0,0 +1,79 @@
+#version 430 core
+
+#define EYE eye.xyz
+#define FAR nfwh.y
+#define WIDTH nfwh.z
+#define HEIGHT nfwh.w
+
+// pixels per side of a tile, the workgroup size of depth.glsl
+#define CONE_TILE 8
+#define CONE_MAX_STEPS 60
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding=2) uniform CAM_BUF
+{
+    mat4 IVP;
+    vec4 eye;
+    vec4 nfwh;
+    vec4 seed;
+    ivec4 limits;   // bounces, march steps, bounces before roulette, roulette on
+};
+
+layout(binding = 4, r32f) uniform writeonly image2D cone_depth;
+
+#include "scene.glsl"
+
+layout(std430, binding = 8) buffer STEP_BUF
+{
+    uint primary_steps;
+    uint cone_steps;
+    uint rays;
+    uint ray_steps;
+};
+uniform int count_steps;
+
+vec3 cone_ray(vec2 pix){
+    const vec2 uv = pix / vec2(WIDTH, HEIGHT) * 2.0 - 1.0;
+    const vec4 t = IVP * vec4(uv, 0.0, 1.0);
+    return normalize(t.xyz / t.w - EYE);
+}
+
+// Marches one cone around the primary rays of a tile. At distance t along
+// the centre ray every other ray of the tile is within spread * t of the
+// centre sample. After a step the cone has widened to spread * (t + step),
+// so all of it stays inside the empty sphere there while
+// step + spread * (t + step) is at most the distance d, that is while
+// step <= (d - spread * t) / (1 + spread). The distance reached is
+// therefore free space along every ray of the tile.
+void main(){
+    const ivec2 tile = ivec2(gl_GlobalInvocationID.xy);
+    if(any(greaterThanEqual(tile, imageSize(cone_depth))))
+        return;
+
+    // antialiasing moves pixels by up to half a pixel
+    const vec2 lo = vec2(tile * CONE_TILE) - 0.5;
+    const vec2 hi = lo + float(CONE_TILE);
+    const vec3 rd = cone_ray((lo + hi) * 0.5);
+    const float spread = max(
+        max(distance(cone_ray(lo), rd), distance(cone_ray(hi), rd)),
+        max(distance(cone_ray(vec2(lo.x, hi.y)), rd), distance(cone_ray(vec2(hi.x, lo.y)), rd)));
+
+    float t = 0.0;
+    int steps = 0;
+    while(steps < CONE_MAX_STEPS && t < FAR){
+        const float radius = spread * t;
+        const float step = (scene_map(EYE + rd * t).x - radius) / (1.0 + spread);
+        ++steps;
+        if(step <= 0.0)
+            break;
+        t += step;
+        // near a surface the steps only shrink, leave the rest to the pixels
+        if(step < 0.25 * radius)
+            break;
+    }
+
+    imageStore(cone_depth, tile, vec4(min(t, FAR)));
+    if(count_steps != 0)
+        atomicAdd(cone_steps, uint(steps));
+}
@@ -0,0 +1,32 @@
+#ifndef CONE_H
+#define CONE_H
+
+#include "compute_shader.h"
+#include "texture.h"
+
+class SDF_Edits;
+class BrickMap;
+
+// must match cone.glsl and the workgroup size of depth.glsl
+#define CONE_TILE 8
+
+/*
+    Depth prepass at one cone per CONE_TILE^2 pixel tile. Each cone is
+    marched until it nears a surface, and the distance reached becomes the
+    starting distance of every primary ray in its tile.
+*/
+class ConePrepass{
+    Texture1f depths;
+    unsigned width, height; // in tiles
+    bool enabled;
+public:
+    ConePrepass() : width(0), height(0), enabled(true){}
+    void init(int screen_width, int screen_height, unsigned image);
+    inline void toggle(){ enabled = !enabled; }
+    inline bool on()const{ return enabled; }
+    // prog is cone.glsl or a generated variant of it
+    void run(ComputeShader& prog, SDF_Edits& edits, BrickMap& bricks, int distance_unit);
+    void uniform(ComputeShader& shader);
+};
+
+#endif
@@ -0,0 +1,306 @@
+#include "cpu_tracer.h"
+#include "sdf.h"
+#include "sdf_cpu.h"
+#include "simd.h"
+#include "brdf.h"
+
+using namespace glm;
+
+// the helpers below follow their namesakes in depth.glsl
+
+static float randUni(u32& f){
+    f = (f ^ 61) ^ (f >> 16);
+    f *= 9;
+    f = f ^ (f >> 4);
+    f *= 0x27d4eb2d;
+    f = f ^ (f >> 15);
+    return fract(float(f) * 2.3283064e-10f);
+}
+
+static float rand(u32& f){
+    return randUni(f) * 2.0f - 1.0f;
+}
+
+static vec2 uv_from_ray(const vec3& N, const vec3& p){
+    const vec3 d = abs(N);
+    const float a = glm::max(glm::max(d.x, d.y), d.z);
+    if(a == d.x)
+        return vec2(p.z, p.y);
+    else if(a == d.y)
+        return vec2(p.x, p.z);
+    return vec2(p.x, p.y);
+}
+
+// bilinear with repeat, like the mip-mapped textures at their finest level;
+// missing images read as opaque black, as incomplete textures do
+vec4 CPUTracer::sample(int texture, vec2 uv)const{
+    const image& img = textures[texture];
+    if(!img.data)
+        return vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const vec2 f = uv * vec2(img.width, img.height) - 0.5f;
+    const vec2 fl = floor(f);
+    const vec2 w = f - fl;
+    vec4 texels[4];
+    for(int i = 0; i < 4; ++i){
+        int x = (int(fl.x) + (i & 1)) % img.width;
+        int y = (int(fl.y) + (i >> 1)) % img.height;
+        x += x < 0 ? img.width : 0;
+        y += y < 0 ? img.height : 0;
+        const u8* t = img.data + 4 * (y * img.width + x);
+        texels[i] = vec4(t[0], t[1], t[2], t[3]) * (1.0f / 255.0f);
+    }
+    return mix(mix(texels[0], texels[1], w.x), mix(texels[2], texels[3], w.x), w.y);
+}
+
+unsigned long long CPUTracer::trace_tile(const SDF_Edits& edits, const Uniforms& uni, int tile){
+    const float e = 0.001f;
+    const int tiles_x = (width + CPU_TILE - 1) / CPU_TILE;
+    const ivec2 lo = ivec2(tile % tiles_x, tile / tiles_x) * CPU_TILE;
+    const vec3 EYE = vec3(uni.eye);
+    unsigned long long count = 0;
+
+    for(int py = lo.y; py < lo.y + CPU_TILE && py < height; ++py){
+        for(int px = lo.x; px < lo.x + CPU_TILE && px < width; px += SIMD_WIDTH){
+            float eye[3][SIMD_WIDTH], rd[3][SIMD_WIDTH];
+            float alive[SIMD_WIDTH];
+            u32 s[SIMD_WIDTH];
+            vec3 col[SIMD_WIDTH], mask[SIMD_WIDTH];
+
+            for(int l = 0; l < SIMD_WIDTH; ++l){
+                const ivec2 pix(px + l, py);
+                s[l] = u32(uni.seed.z + 10000.0f * dot(vec2(uni.seed), vec2(pix)));
+                const vec2 aa = vec2(rand(s[l]), rand(s[l])) * 0.5f;
+                const vec2 uv = (vec2(pix) + aa) / vec2(width, height) * 2.0f - 1.0f;
+                const vec4 t = uni.IVP * vec4(uv.x, uv.y, 0.0f, 1.0f);
+                const vec3 r = normalize(vec3(t / t.w) - EYE);
+                for(int c = 0; c < 3; ++c){
+                    eye[c][l] = EYE[c];
+                    rd[c][l] = r[c];
+                }
+                alive[l] = pix.x < width ? 1.0f : 0.0f;
+                col[l] = vec3(0.0f);
+                mask[l] = vec3(1.0f);
+            }
+
+            for(int i = 0; i < uni.limits.x; i++){
+                vvec3 p, dir;
+                p.x = vfloat::load(eye[0]);
+                p.y = vfloat::load(eye[1]);
+                p.z = vfloat::load(eye[2]);
+                dir.x = vfloat::load(rd[0]);
+                dir.y = vfloat::load(rd[1]);
+                dir.z = vfloat::load(rd[2]);
+                vfloat active = vfloat::load(alive) > 0.0f;
+                if(!vany(active))
+                    break;
+                for(int l = 0; l < SIMD_WIDTH; ++l){
+                    count += alive[l] != 0.0f ? 1 : 0;
+                }
+
+                vfloat sid = -1.0f;
+                for(int j = 0; j < uni.limits.y; j++){
+                    vfloat d, id;
+                    sdf_map_packet(edits, p, d, id);
+                    sid = vselect(active, id, sid);
+                    active = andnot(vabs(d) < e, active);
+                    if(!vany(active))
+                        break;
+                    p.x = vselect(active, p.x + dir.x * d, p.x);
+                    p.y = vselect(active, p.y + dir.y * d, p.y);
+                    p.z = vselect(active, p.z + dir.z * d, p.z);
+                }
+                p.x.store(eye[0]);
+                p.y.store(eye[1]);
+                p.z.store(eye[2]);
+                float ids[SIMD_WIDTH];
+                sid.store(ids);
+
+                for(int l = 0; l < SIMD_WIDTH; ++l){
+                    if(alive[l] == 0.0f)
+                        continue;
+                    const int sdf_id = int(ids[l]);
+                    if(sdf_id < 0 || sdf_id >= edits.count()){
+                        alive[l] = 0.0f;
+                        continue;
+                    }
+                    vec3 pos(eye[0][l], eye[1][l], eye[2][l]);
+                    const vec3 r(rd[0][l], rd[1][l], rd[2][l]);
+                    const SDF& sdf = edits[sdf_id];
+                    // rays that ran out of steps far past every edit have no gradient
+                    const vec3 g = sdf_map_dual(edits, pos).g;
+                    if(g == vec3(0.0f)){
+                        alive[l] = 0.0f;
+                        continue;
+                    }
+                    const int mat = sdf.material_id() == 1 || sdf.material_id() == 2 ? sdf.material_id() : 0;
+
+                    vec3 N;
+                    vec2 uv;
+                    {
+                        mat3 TBN;
+                        TBN[2] = normalize(g);
+                        TBN[0] = normalize(cross(TBN[2], normalize(vec3(0.01f * rand(s[l]), 1.0f, 0.0f))));
+                        TBN[1] = cross(TBN[2], TBN[0]);
+                        uv = uv_from_ray(TBN[2], pos) * sdf.uv_scale();
+                        const vec4 tN = sample(mat * 3 + 1, uv);
+                        N = TBN * normalize(vec3(tN) * 2.0f - 1.0f);
+                    }
+
+                    const vec3 V = -r;
+                    pos += N * e * 4.0f;
+
+                    const vec4 albedo = sample(mat * 3, uv);
+                    const vec4 material = sample(mat * 3 + 2, uv);
+
+                    col[l] += mask[l] * vec3(albedo) * albedo.a * 100.0f;
+                    const float u0 = randUni(s[l]);
+                    const float u1 = randUni(s[l]);
+                    vec3 weight;
+                    const vec3 L = sample_brdf(V, N, vec3(albedo), material.x, material.y, vec2(u0, u1), weight);
+                    mask[l] *= weight;
+                    const int bounces = i + 1;
+                    if(uni.limits.w != 0 && bounces >= uni.limits.z && bounces < uni.limits.x){
+                        const float keep = roulette_chance(mask[l], bounces);
+                        if(randUni(s[l]) >= keep){
+                            alive[l] = 0.0f;
+                            continue;
+                        }
+                        mask[l] /= keep;
+                    }
+                    for(int c = 0; c < 3; ++c){
+                        eye[c][l] = pos[c];
+                        rd[c][l] = L[c];
+                    }
+                }
+            }
+
+            const float alpha = 1.0f / uni.seed.w;
+            for(int l = 0; l < SIMD_WIDTH && px + l < width; ++l){
+                vec4& dst = accum[py * width + px + l];
+                dst = vec4(mix(vec3(dst), col[l], alpha), 1.0f);
+            }
+        }
+    }
+    return count;
+}
+
+// lo in the low half, hi in the high half
+static bool pop_front(std::atomic<u64>& range, int& tile){
+    u64 cur = range.load();
+    for(;;){
+        const u32 lo = u32(cur), hi = u32(cur >> 32);
+        if(lo >= hi)
+            return false;
+        if(range.compare_exchange_weak(cur, (u64(hi) << 32) | (lo + 1))){
+            tile = lo;
+            return true;
+        }
+    }
+}
+
+static bool pop_back(std::atomic<u64>& range, int& tile){
+    u64 cur = range.load();
+    for(;;){
+        const u32 lo = u32(cur), hi = u32(cur >> 32);
+        if(lo >= hi)
+            return false;
+        if(range.compare_exchange_weak(cur, (u64(hi - 1) << 32) | lo)){
+            tile = hi - 1;
+            return true;
+        }
+    }
+}
+
+void CPUTracer::work(int self){
+    unsigned long long count = 0;
+    int tile;
+    while(pop_front(ranges[self], tile)){
+        count += trace_tile(*job_edits, *job_uni, tile);
+    }
+    for(int i = 1; i < threads; ++i){
+        std::atomic<u64>& victim = ranges[(self + i) % threads];
+        while(pop_back(victim, tile)){
+            count += trace_tile(*job_edits, *job_uni, tile);
+        }
+    }
+    counts[self] = count;
+}
+
+void CPUTracer::worker(int self){
+    unsigned seen = 0;
+    for(;;){
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]{ return quit || generation != seen; });
+            if(quit)
+                return;
+            seen = generation;
+        }
+        work(self);
+        std::lock_guard<std::mutex> lock(mutex);
+        if(--busy == 0)
+            finished.notify_one();
+    }
+}
+
+void CPUTracer::stop(){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+    for(int i = 0; i < workers.count(); ++i){
+        workers[i]->join();
+        delete workers[i];
+    }
+    workers.clear();
+    quit = false;
+}
+
+void CPUTracer::init(int w, int h, int num_threads){
+    stop();
+    width = w;
+    height = h;
+    threads = num_threads > 0 ? num_threads : glm::max(1, int(std::thread::hardware_concurrency()));
+    ranges.reset(new std::atomic<u64>[threads]);
+    counts.resize(threads);
+    for(int i = 1; i < threads; ++i){
+        workers.grow() = new std::thread(&CPUTracer::worker, this, i);
+    }
+    accum.resize(width * height);
+    for(int i = 0; i < accum.count(); ++i){
+        accum[i] = vec4(0.0f);
+    }
+    for(int i = 0; i < MATERIAL_TEXTURE_COUNT; ++i){
+        if(!textures[i].data)
+            textures[i].load(material_files[i]);
+        if(!textures[i].data)
+            printf("cpu tracer: could not load %s\n", material_files[i]);
+    }
+}
+
+void CPUTracer::render(const SDF_Edits& edits, const Uniforms& uni){
+    const int tiles = ((width + CPU_TILE - 1) / CPU_TILE) * ((height + CPU_TILE - 1) / CPU_TILE);
+    for(int i = 0; i < threads; ++i){
+        const u64 lo = u64(tiles) * i / threads, hi = u64(tiles) * (i + 1) / threads;
+        ranges[i] = (hi << 32) | lo;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job_edits = &edits;
+        job_uni = &uni;
+        busy = workers.count();
+        ++generation;
+    }
+    wake.notify_all();
+    work(0);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]{ return busy == 0; });
+    }
+    rays = 0;
+    for(int i = 0; i < threads; ++i){
+        rays += counts[i];
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef CPU_TRACER_H
+#define CPU_TRACER_H
+
+#include "glm/glm.hpp"
+#include "array.h"
+#include "image.h"
+#include "uniforms.h"
+#include "materials.h"
+#include "ints.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+class SDF_Edits;
+
+// pixels per side of the tiles handed out to the threads
+#define CPU_TILE 8
+
+/*
+    Path tracer on the cpu for machines without a gpu, mirroring depth.glsl:
+    the same edit fold, lighting, random numbers and accumulation into an
+    rgba32f buffer laid out like colTex. It does not sample the emitters,
+    which changes its noise but not the image it converges to. Rays march
+    in packets of SIMD_WIDTH pixels; tiles are split evenly between the
+    threads, and a thread that runs out takes tiles from the back of the
+    others' ranges. The threads are started by init() and wait between
+    renders, with the calling thread tracing as the first of them.
+*/
+class CPUTracer{
+    Vector<glm::vec4> accum;
+    image textures[MATERIAL_TEXTURE_COUNT];
+    int width, height, threads;
+    unsigned long long rays;
+
+    // the pool, woken for each render by a new generation
+    Vector<std::thread*> workers;
+    std::mutex mutex;
+    std::condition_variable wake, finished;
+    unsigned generation;
+    int busy;
+    bool quit;
+    // the render the pool is working on
+    const SDF_Edits* job_edits;
+    const Uniforms* job_uni;
+    std::unique_ptr<std::atomic<u64>[]> ranges;
+    Vector<unsigned long long> counts;
+
+    glm::vec4 sample(int texture, glm::vec2 uv)const;
+    unsigned long long trace_tile(const SDF_Edits& edits, const Uniforms& uni, int tile);
+    void work(int self);
+    void worker(int self);
+    void stop();
+public:
+    CPUTracer() : width(0), height(0), threads(0), rays(0), generation(0), busy(0), quit(false),
+        job_edits(nullptr), job_uni(nullptr){}
+    ~CPUTracer(){ stop(); }
+    // threads of 0 uses every core
+    void init(int width, int height, int threads = 0);
+    // traces one sample per pixel and blends it in by 1 / uni.seed.w
+    void render(const SDF_Edits& edits, const Uniforms& uni);
+    inline const glm::vec4* accumulation()const{ return accum.begin(); }
+    // march segments traced by the last render, primary rays and bounces
+    inline unsigned long long last_rays()const{ return rays; }
+    inline int thread_count()const{ return threads; }
+};
+
+#endif
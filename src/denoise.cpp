@@ -0,0 +1,49 @@
+#include "denoise.h"
+#include "reprojection.h"
+#include "timer.h"
+
+static const char* const pass_names[DENOISE_PASSES] = { "demod", "atrous1", "atrous2", "atrous3", "atrous4", "atrous5" };
+
+Denoiser::Denoiser()
+    : filter("assets/denoise.glsl"), timers(nullptr), width(0), height(0), result(0), enabled(false){
+    for(int i = 0; i < DENOISE_PASSES; ++i)
+        scopes[i] = -1;
+}
+
+void Denoiser::init(int w, int h, unsigned gbuffer_binding, FrameTimers* frame_timers){
+    width = w;
+    height = h;
+    for(int i = 0; i < 2; ++i)
+        images[i].init(width, height);
+    gbuffer.init(nullptr, 0, gbuffer_binding);
+    gbuffer.upload(nullptr, width * height * 2 * sizeof(unsigned));
+    timers = frame_timers;
+    if(timers){
+        for(int i = 0; i < DENOISE_PASSES; ++i)
+            scopes[i] = timers->scope(pass_names[i]);
+    }
+}
+
+void Denoiser::uniform(ComputeShader& depth){
+    depth.setUniformInt("gbuffer_enabled", enabled ? 1 : 0);
+}
+
+void Denoiser::run(Reprojection& history){
+    filter.bind();
+    history.color().bind(14, "color", filter);
+    history.first_hits().bind(15, "first_hits", filter);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+    for(int i = 0; i < DENOISE_PASSES; ++i){
+        result = i & 1;
+        images[result ^ 1].setCSBinding(5, GL_READ_ONLY);
+        images[result].setCSBinding(6, GL_WRITE_ONLY);
+        if(timers)
+            timers->begin(scopes[i]);
+        filter.setUniformInt("denoise_step", i == 0 ? 0 : 1 << (i - 1));
+        filter.setUniformInt("denoise_last", i + 1 == DENOISE_PASSES ? 1 : 0);
+        filter.call((width + 7) / 8, (height + 7) / 8, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+        if(timers)
+            timers->end(scopes[i]);
+    }
+}
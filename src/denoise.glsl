@@ -0,0 +1,121 @@
+#version 430 core
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+#include "octahedral.glsl"
+
+// written by depth.glsl this frame
+uniform sampler2D color;
+uniform sampler2D first_hits;
+layout(std430, binding = 10) readonly buffer GBUFFER_BUF
+{
+    uvec2 gbuffer[]; // albedo as unorm4x8, object id
+};
+
+// illumination and the variance of its luminance
+layout(binding = 5, rgba32f) uniform readonly image2D src;
+layout(binding = 6, rgba32f) uniform writeonly image2D dst;
+
+uniform int denoise_step; // 0 demodulates color, then the a-trous spacing in pixels
+uniform int denoise_last; // modulates the result by albedo again
+
+float luminance(vec3 c){
+    return dot(c, vec3(0.2126, 0.7152, 0.0722));
+}
+
+vec3 albedo_at(ivec2 p, ivec2 size){
+    // dark albedo would blow the noise up rather than remove it
+    return max(unpackUnorm4x8(gbuffer[p.y * size.x + p.x].x).rgb, vec3(0.01));
+}
+
+// per pixel variance of the mean from the luminance moments kept with the
+// history, or from the 3x3 neighbourhood until there are a few samples
+vec4 demodulate(ivec2 pix, ivec2 size){
+    const vec4 c = texelFetch(color, pix, 0);
+    const vec3 a = albedo_at(pix, size);
+    const vec3 illumination = c.rgb / a;
+    const float n = max(c.w, 1.0);
+    const float scale = 1.0 / max(luminance(a), 0.01);
+    float variance;
+    if(n >= 4.0){
+        const float mean = luminance(c.rgb);
+        variance = max(texelFetch(first_hits, pix, 0).w - mean * mean, 0.0) * scale * scale / n;
+    }
+    else{
+        float m1 = 0.0, m2 = 0.0;
+        for(int i = 0; i < 9; ++i){
+            const ivec2 q = clamp(pix + ivec2(i % 3 - 1, i / 3 - 1), ivec2(0), size - 1);
+            const float l = luminance(texelFetch(color, q, 0).rgb / albedo_at(q, size));
+            m1 += l;
+            m2 += l * l;
+        }
+        m1 /= 9.0;
+        variance = max(m2 / 9.0 - m1 * m1, 0.0) / n;
+    }
+    return vec4(illumination, variance);
+}
+
+// one a-trous iteration of a 5x5 B3 spline kernel, stopped at edges in
+// normal, depth, object and luminance relative to the local deviation
+vec4 atrous(ivec2 pix, ivec2 size){
+    const float kernel[3] = float[3](3.0 / 8.0, 1.0 / 4.0, 1.0 / 16.0);
+    const vec4 center = imageLoad(src, pix);
+    const vec4 h = texelFetch(first_hits, pix, 0);
+    const uint id = gbuffer[pix.y * size.x + pix.x].y;
+    const vec3 N = oct_decode(h.xy);
+
+    float variance = 0.0;
+    for(int i = 0; i < 9; ++i){
+        const ivec2 o = ivec2(i % 3 - 1, i / 3 - 1);
+        const ivec2 q = clamp(pix + o, ivec2(0), size - 1);
+        variance += (o.x == 0 ? 0.5 : 0.25) * (o.y == 0 ? 0.5 : 0.25) * imageLoad(src, q).a;
+    }
+    const float sigma_l = 4.0 * sqrt(variance) + 0.0001;
+
+    // smallest one sided change in distance per pixel along x and y
+    vec2 gradient = vec2(0.0);
+    for(int i = 0; i < 2; ++i){
+        const ivec2 o = ivec2(i == 0 ? 1 : 0, i == 1 ? 1 : 0);
+        const float a = texelFetch(first_hits, clamp(pix + o, ivec2(0), size - 1), 0).z;
+        const float b = texelFetch(first_hits, clamp(pix - o, ivec2(0), size - 1), 0).z;
+        gradient[i] = min(a >= 0.0 ? abs(a - h.z) : 1e6, b >= 0.0 ? abs(b - h.z) : 1e6);
+    }
+    gradient = min(gradient, vec2(h.z));
+
+    vec3 sum = vec3(0.0);
+    float sum_variance = 0.0, weights = 0.0;
+    for(int y = -2; y <= 2; ++y){
+        for(int x = -2; x <= 2; ++x){
+            const ivec2 q = pix + ivec2(x, y) * denoise_step;
+            if(any(lessThan(q, ivec2(0))) || any(greaterThanEqual(q, size)))
+                continue;
+            const vec4 c = imageLoad(src, q);
+            float w = kernel[abs(x)] * kernel[abs(y)];
+            if(x != 0 || y != 0){
+                const vec4 hq = texelFetch(first_hits, q, 0);
+                if((h.z < 0.0) != (hq.z < 0.0) || gbuffer[q.y * size.x + q.x].y != id)
+                    continue;
+                if(h.z >= 0.0){
+                    w *= pow(max(dot(N, oct_decode(hq.xy)), 0.0), 128.0);
+                    w *= exp(-abs(hq.z - h.z) / (dot(gradient, abs(vec2(q - pix))) + 0.01 * h.z));
+                }
+                w *= exp(-abs(luminance(c.rgb) - luminance(center.rgb)) / sigma_l);
+            }
+            sum += w * c.rgb;
+            sum_variance += w * w * c.a;
+            weights += w;
+        }
+    }
+    return vec4(sum / weights, sum_variance / (weights * weights));
+}
+
+void main(){
+    const ivec2 pix = ivec2(gl_GlobalInvocationID.xy);
+    const ivec2 size = textureSize(color, 0);
+    if (pix.x >= size.x || pix.y >= size.y) return;
+
+    vec4 result = denoise_step == 0 ? demodulate(pix, size) : atrous(pix, size);
+    if(denoise_last != 0)
+        result = vec4(result.rgb * albedo_at(pix, size), 1.0);
+    imageStore(dst, pix, result);
+}
@@ -0,0 +1,50 @@
+#ifndef DENOISE_H
+#define DENOISE_H
+
+#include "compute_shader.h"
+#include "texture.h"
+#include "SSBO.h"
+
+class Reprojection;
+class FrameTimers;
+
+// a-trous iterations at spacings of 1, 2, 4... pixels
+#define DENOISE_ITERATIONS 5
+#define DENOISE_PASSES (DENOISE_ITERATIONS + 1)
+
+/*
+    Edge-aware filter of the accumulation before it is shown, after SVGF.
+    depth.glsl writes each pixel's first hit albedo and object id to a
+    G-buffer next to the normal and distance it already keeps in the hits
+    image. The color is divided by albedo, and the variance of its
+    luminance taken from the moments kept with the history; a-trous
+    iterations then blur it where normals, depths and objects agree and
+    the luminance difference is within the remaining noise, each also
+    filtering the variance, and the last multiplies albedo back in.
+
+    Uses image units 5 and 6, free once depth.glsl has run and bound
+    again by Reprojection::next, and texture units 14 and 15.
+*/
+class Denoiser{
+    ComputeShader filter;
+    Texture4f images[2];
+    SSBO gbuffer;
+    FrameTimers* timers;
+    int scopes[DENOISE_PASSES];
+    unsigned width, height;
+    int result;
+    bool enabled;
+public:
+    Denoiser();
+    // timers, when set, gets a scope per pass
+    void init(int width, int height, unsigned gbuffer_binding, FrameTimers* timers);
+    inline void toggle(){ enabled = !enabled; }
+    inline bool on()const{ return enabled; }
+    // has depth.glsl write the G-buffer while the denoiser is on
+    void uniform(ComputeShader& depth);
+    // filters the color depth.glsl wrote this frame
+    void run(Reprojection& history);
+    inline Texture4f& output(){ return images[result]; }
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "emitters.h"
+#include "sdf.h"
+#include "image.h"
+#include "array.h"
+
+using namespace glm;
+
+// must match emitters.glsl
+struct Emitter{
+    vec4 sphere;    // center, radius
+    vec4 pick;      // chance of this or an earlier emitter, of this one, edit index
+};
+
+void EmitterList::init(unsigned binding){
+    for(int m = 0; m < MATERIAL_TEXTURE_COUNT / 3; ++m){
+        image img;
+        img.load(material_files[m * 3]);
+        double sum = 0.0;
+        const int texels = img.data ? img.width * img.height : 0;
+        for(int i = 0; i < texels; ++i){
+            const u8* t = img.data + 4 * i;
+            sum += (0.2126 * t[0] + 0.7152 * t[1] + 0.0722 * t[2]) * t[3] / (255.0 * 255.0);
+        }
+        emission[m] = texels ? float(100.0 * sum / texels) : 0.0f;
+    }
+    unsigned zero[4] = { 0, 0, 0, 0 };
+    list.init(zero, sizeof(zero), binding);
+    dirty = true;
+}
+
+bool EmitterList::emits(const SDF& sdf, vec4& sphere, float& power)const{
+    // as depth.glsl maps material ids to textures
+    const int mat = sdf.material_id() == 1 || sdf.material_id() == 2 ? sdf.material_id() : 0;
+    if(!enabled || !sdf.bounded() || !sdf.additive() || emission[mat] <= 0.0f)
+        return false;
+    const AABB box = sdf.bounds();
+    const vec3 e = box.extent();
+    sphere = vec4(box.center(), length(e));
+    power = emission[mat] * 8.0f * (e.x * e.y + e.y * e.z + e.z * e.x);
+    return true;
+}
+
+void EmitterList::update(const SDF_Edits& edits){
+    // the brush is set every frame, so only its own entry is compared
+    const int last = edits.count() - 1;
+    vec4 sphere(0.0f);
+    float power = 0.0f;
+    emits(edits[last], sphere, power);
+    if(!dirty && version == edits.committed_version() && sphere == brush && power == brush_power)
+        return;
+    version = edits.committed_version();
+    brush = sphere;
+    brush_power = power;
+    dirty = false;
+
+    Vector<Emitter> emitters;
+    double total = 0.0;
+    for(int i = 0; i < edits.count(); ++i){
+        if(!emits(edits[i], sphere, power))
+            continue;
+        Emitter& em = emitters.grow();
+        em.sphere = sphere;
+        em.pick = vec4(0.0f, power, float(i), 0.0f);
+        total += em.pick.y;
+    }
+    double sum = 0.0;
+    for(int i = 0; i < emitters.count(); ++i){
+        emitters[i].pick.y = float(emitters[i].pick.y / total);
+        sum += emitters[i].pick.y;
+        emitters[i].pick.x = i + 1 == emitters.count() ? 1.0f : float(sum);
+    }
+    count = emitters.count();
+
+    unsigned header[4] = { unsigned(count), 0, 0, 0 };
+    list.upload(nullptr, sizeof(header) + emitters.bytes());
+    list.update(header, sizeof(header));
+    if(count)
+        list.update(emitters.begin(), emitters.bytes(), sizeof(header));
+}
@@ -0,0 +1,122 @@
+// Next event estimation towards the emissive edits of emitters.h, weighed
+// against sample_brdf by the power heuristic. Needs scene.glsl and
+// shading.glsl.
+
+struct Emitter {
+    vec4 sphere;  // xyz: center, w: radius around the edit's bounds
+    vec4 pick;    // x: chance of picking this or an earlier emitter, y: this one, z: edit index
+};
+
+layout(std430, binding = 16) readonly buffer EMITTER_BUF
+{
+    uint emitter_count;
+    uint emitter_pad0;
+    uint emitter_pad1;
+    uint emitter_pad2;
+    Emitter emitters[];
+};
+
+// one minus the cosine of the half angle of the cone the emitter's sphere
+// fills seen from p, kept precise for small and far spheres; 0 from
+// inside, where it is never sampled
+float emitter_cone(Emitter em, vec3 p){
+    const vec3 d = em.sphere.xyz - p;
+    const float x = em.sphere.w * em.sphere.w / dot(d, d);
+    return x >= 1.0 ? 0.0 : x / (1.0 + sqrt(1.0 - x));
+}
+
+// density of picking L from p towards the emitter of edit, 0 when it is not listed
+float emitter_pdf(int edit, vec3 p, vec3 L){
+    int lo = 0;
+    int hi = int(emitter_count) - 1;
+    while(lo <= hi){
+        const int mid = (lo + hi) / 2;
+        const int e = int(emitters[mid].pick.z);
+        if(e < edit)
+            lo = mid + 1;
+        else if(e > edit)
+            hi = mid - 1;
+        else{
+            const Emitter em = emitters[mid];
+            const float cone = emitter_cone(em, p);
+            if(cone <= 0.0 || dot(L, normalize(em.sphere.xyz - p)) < 1.0 - cone)
+                return 0.0;
+            return em.pick.y / (6.2831853 * cone);
+        }
+    }
+    return 0.0;
+}
+
+// a^2 / (a^2 + b^2), without squaring the large densities of small lights;
+// 0 for the nan density of a degenerate brdf sample
+float power_heuristic(float a, float b){
+    if(!(a > 0.0))
+        return 0.0;
+    const float r = b / a;
+    return 1.0 / (1.0 + r * r);
+}
+
+// how much of the emission a path hits along a direction sample_brdf
+// picked from p with brdf_density keeps, the rest being left to light sampling
+float emission_weight(int edit, vec3 p, vec3 L, float brdf_density){
+    if(emitter_count == 0u)
+        return 1.0;
+    return power_heuristic(brdf_density, emitter_pdf(edit, p, L));
+}
+
+// light reaching p towards V from an emitter picked by power, in a direction
+// picked uniformly in the cone of its sphere, through the brdf; scaled like
+// the weights of sample_brdf
+vec3 sample_emitters(vec3 p, vec3 V, vec3 N, vec3 albedo, float metalness, float roughness, inout uint s, uint pair){
+    if(emitter_count == 0u)
+        return vec3(0.0);
+    vec2 u = sample2(s, pair);
+    int lo = 0;
+    int hi = int(emitter_count) - 1;
+    while(lo < hi){
+        const int mid = (lo + hi) / 2;
+        if(emitters[mid].pick.x < u.x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    const Emitter em = emitters[lo];
+    // stretched back over [0, 1) within the emitter's share
+    u.x = clamp((u.x - (em.pick.x - em.pick.y)) / em.pick.y, 0.0, 1.0);
+    const float cone = emitter_cone(em, p);
+    if(cone <= 0.0)
+        return vec3(0.0);
+    const float x = u.x * cone;
+    const float cos_t = 1.0 - x;
+    const float sin_t = sqrt(max(0.0, x * (2.0 - x)));
+    const float phi = 6.2831853 * u.y;
+    const vec3 L = basis(normalize(em.sphere.xyz - p)) * vec3(sin_t * cos(phi), sin_t * sin(phi), cos_t);
+    if(dot(N, L) <= 0.0)
+        return vec3(0.0);
+
+    // the shadow ray gives up at the first other surface or once past the sphere
+    const float e = 0.001;
+    const float t_max = distance(em.sphere.xyz, p) + em.sphere.w;
+    float t = 0.0;
+    vec2 sam;
+    int j;
+    for(j = 0; j < limits.y; j++){
+        sam = scene_map(p + L * t);
+        if(abs(sam.x) < e)
+            break;
+        t += sam.x;
+        if(t > t_max)
+            return vec3(0.0);
+    }
+    // like the paths, rays out of steps take the edit they ended nearest
+    const int edit = int(em.pick.z);
+    if(int(sam.y) != edit)
+        return vec3(0.0);
+
+    const vec3 q = p + L * t;
+    const vec2 uv = uv_from_ray(scene_map_normal(q), q) * sdf_uv_scale(edit);
+    const vec4 albedo_e = sdf_albedo_texture(edit, uv);
+    const float light_pdf = em.pick.y / (6.2831853 * cone);
+    const float w = power_heuristic(light_pdf, brdf_density(V, L, N, albedo, metalness, roughness));
+    return pbr_lighting(V, L, N, albedo, metalness, roughness) * albedo_e.rgb * albedo_e.a * 100.0 * w / (6.2831853 * light_pdf);
+}
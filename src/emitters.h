@@ -0,0 +1,44 @@
+#ifndef EMITTERS_H
+#define EMITTERS_H
+
+#include "compute_shader.h"
+#include "SSBO.h"
+#include "materials.h"
+
+class SDF;
+class SDF_Edits;
+
+/*
+    Emissive edits for next event estimation in emitters.glsl. Every
+    bounded union edit whose material emits is listed with the sphere
+    around its bounds, in edit order, and picked with a chance
+    proportional to its power: the mean emission of its material's albedo
+    map times the surface of its bounds. Rebuilt when an edit is committed
+    or undone, or when the brush's own entry changes. Switched off, the list is empty and paths only find emitters by
+    sampling the brdf.
+
+    Storage: the count and the emitters at one ssbo binding.
+*/
+class EmitterList{
+    SSBO list;
+    // mean emission of each material, as depth.glsl reads it from albedo alpha
+    float emission[MATERIAL_TEXTURE_COUNT / 3];
+    // committed_version() of the edits listed, and the sphere and power the
+    // brush was listed with, 0 when it does not emit
+    unsigned version;
+    glm::vec4 brush;
+    float brush_power;
+    int count;
+    bool enabled, dirty;
+    // the sphere and unnormalized power of sdf, false when it does not emit
+    bool emits(const SDF& sdf, glm::vec4& sphere, float& power)const;
+public:
+    EmitterList() : version(0), brush(0.0f), brush_power(0.0f), count(0), enabled(true), dirty(true){}
+    void init(unsigned binding);
+    inline void toggle(){ enabled = !enabled; dirty = true; }
+    inline bool on()const{ return enabled; }
+    void update(const SDF_Edits& edits);
+    inline int emitter_count()const{ return count; }
+};
+
+#endif
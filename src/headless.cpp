@@ -0,0 +1,81 @@
+#include "headless.h"
+
+#include "myglheaders.h"
+#include <iostream>
+
+using namespace std;
+
+#ifdef HEADLESS_EGL
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+Headless::Headless(int major_ver, int minor_ver){
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    EGLDisplay dpy = getPlatformDisplay ?
+        getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL) :
+        eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if(dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, NULL, NULL)){
+        cerr << "Failed to initialize EGL" << endl;
+        exit(1);
+    }
+    if(!eglBindAPI(EGL_OPENGL_API)){
+        cerr << "EGL has no desktop OpenGL" << endl;
+        exit(1);
+    }
+    // a surface type of 0 matches configs without window or pbuffer support
+    const EGLint config_attribs[] = {
+        EGL_SURFACE_TYPE, 0,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint num_configs = 0;
+    if(!eglChooseConfig(dpy, config_attribs, &config, 1, &num_configs) || num_configs < 1){
+        cerr << "No EGL config for OpenGL" << endl;
+        exit(1);
+    }
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, major_ver,
+        EGL_CONTEXT_MINOR_VERSION, minor_ver,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext ctx = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+    if(ctx == EGL_NO_CONTEXT || !eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, ctx)){
+        cerr << "Failed to create a surfaceless OpenGL " << major_ver << "." << minor_ver << " context" << endl;
+        eglTerminate(dpy);
+        exit(1);
+    }
+    display = dpy;
+    context = ctx;
+
+    glewExperimental=true;
+    // glew also asks glx for its extensions, which fails without an x
+    // display after the core functions are already loaded
+    glewInit();
+    if(!glDispatchCompute){
+        cerr << "Failed to initialize GLEW" << endl;
+        exit(1);
+    }
+    glGetError();
+}
+
+Headless::~Headless(){
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+}
+
+#else
+
+Headless::Headless(int major_ver, int minor_ver) : display(nullptr), context(nullptr){
+    cerr << "Headless contexts need EGL, which this build was configured without" << endl;
+    exit(1);
+}
+
+Headless::~Headless(){
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+/*
+    An OpenGL context without a window or a display server, through EGL's
+    surfaceless platform; Mesa's llvmpipe provides one on machines without
+    a gpu. Rendering goes to textures only, there is no default framebuffer.
+*/
+class Headless{
+private:
+    void* display;
+    void* context;
+public:
+    Headless(int major_ver, int minor_ver);
+    ~Headless();
+};
+#endif
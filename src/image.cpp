@@ -6,4 +6,107 @@
 void image::load(const char* filename){
     int comps = 0;
     data = stbi_load(filename, &width, &height, &comps, 4);
-}
\ No newline at end of file
+}
+
+void write_pfm(const char* filename, const float* rgba, s32 width, s32 height){
+    FILE* f = fopen(filename, "wb");
+    if(!f){
+        printf("could not open %s\n", filename);
+        return;
+    }
+    fprintf(f, "PF\n%d %d\n-1.0\n", width, height);
+    for(s32 i = 0; i < width * height; ++i){
+        fwrite(rgba + 4 * i, sizeof(float), 3, f);
+    }
+    fclose(f);
+}
+
+static u32 crc32(u32 crc, const u8* p, size_t n){
+    static u32 table[256];
+    if(!table[1]){
+        for(u32 i = 0; i < 256; ++i){
+            u32 c = i;
+            for(int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+    }
+    crc = ~crc;
+    for(size_t i = 0; i < n; ++i)
+        crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void put_u32(u8* p, u32 x){
+    p[0] = u8(x >> 24);
+    p[1] = u8(x >> 16);
+    p[2] = u8(x >> 8);
+    p[3] = u8(x);
+}
+
+static void write_chunk(FILE* f, const char* type, const u8* data, u32 length){
+    u8 header[8];
+    put_u32(header, length);
+    memcpy(header + 4, type, 4);
+    fwrite(header, 1, 8, f);
+    fwrite(data, 1, length, f);
+    u8 crc[4];
+    put_u32(crc, crc32(crc32(0, header + 4, 4), data, length));
+    fwrite(crc, 1, 4, f);
+}
+
+void write_png(const char* filename, const u8* rgba, s32 width, s32 height){
+    FILE* f = fopen(filename, "wb");
+    if(!f){
+        printf("could not open %s\n", filename);
+        return;
+    }
+    static const u8 signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    fwrite(signature, 1, 8, f);
+
+    u8 ihdr[13];
+    put_u32(ihdr, width);
+    put_u32(ihdr + 4, height);
+    ihdr[8] = 8;    // bits per channel
+    ihdr[9] = 6;    // rgba
+    ihdr[10] = ihdr[11] = ihdr[12] = 0;
+    write_chunk(f, "IHDR", ihdr, 13);
+
+    // each row is a filter byte of 0 and the pixels, deflated as stored blocks
+    const size_t row = 1 + 4 * size_t(width);
+    const size_t raw_size = row * height;
+    const size_t blocks = (raw_size + 65534) / 65535;
+    u8* idat = (u8*)malloc(2 + blocks * 5 + raw_size + 4);
+    u8* out = idat;
+    *out++ = 0x78;
+    *out++ = 0x01;
+    u32 a = 1, b = 0;
+    size_t block_left = 0, remaining = raw_size;
+    for(s32 y = 0; y < height; ++y){
+        const u8* src = rgba + 4 * size_t(width) * y;
+        for(size_t i = 0; i < row; ++i){
+            if(!block_left){
+                block_left = remaining < 65535 ? remaining : 65535;
+                remaining -= block_left;
+                *out++ = remaining ? 0 : 1;
+                out[0] = u8(block_left);
+                out[1] = u8(block_left >> 8);
+                out[2] = u8(~block_left);
+                out[3] = u8(~block_left >> 8);
+                out += 4;
+            }
+            const u8 byte = i ? src[i - 1] : 0;
+            *out++ = byte;
+            --block_left;
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+    }
+    put_u32(out, (b << 16) | a);
+    out += 4;
+    write_chunk(f, "IDAT", idat, u32(out - idat));
+    free(idat);
+
+    write_chunk(f, "IEND", nullptr, 0);
+    fclose(f);
+}
@@ -10,3 +10,9 @@ struct image{
     void load(const char* filename);
     image(const char* filename){ load(filename); }
 };
+
+// rgba rows bottom to top, as read back from a texture; alpha is dropped
+void write_pfm(const char* filename, const float* rgba, s32 width, s32 height);
+
+// 8 bit rgba rows top to bottom, stored without compression
+void write_png(const char* filename, const u8* rgba, s32 width, s32 height);
@@ -0,0 +1,95 @@
+#include "lpv.h"
+#include "sdf.h"
+#include "image.h"
+#include "myglheaders.h"
+
+using namespace glm;
+
+// must match lpv.glsl
+#define LPV_INJECT 0
+#define LPV_PROPAGATE 1
+
+#define LPV_CELLS (LPV_SIZE * LPV_SIZE * LPV_SIZE)
+#define LPV_TABLE_BYTES (2 * LPV_MATERIALS * sizeof(vec4))
+#define LPV_BYTES (LPV_TABLE_BYTES + LPV_CASCADES * LPV_CELLS * (sizeof(int) + 2 * sizeof(vec4)))
+
+RadianceVolume::RadianceVolume()
+    : prog("assets/lpv.glsl"), commits(0), parity(0), enabled(false), reset(true){
+}
+
+void RadianceVolume::init(unsigned binding){
+    // the mean albedo over 2pi, the scale of a bounce in sample_brdf, and
+    // the mean emission as depth.glsl reads it from albedo alpha
+    vec4 table[2 * LPV_MATERIALS];
+    for(int m = 0; m < LPV_MATERIALS; ++m){
+        image img;
+        img.load(material_files[m * 3]);
+        dvec3 albedo(0.0), emission(0.0);
+        const int texels = img.data ? img.width * img.height : 0;
+        for(int i = 0; i < texels; ++i){
+            const u8* t = img.data + 4 * i;
+            const dvec3 rgb = dvec3(t[0], t[1], t[2]) / 255.0;
+            albedo += rgb;
+            emission += rgb * (t[3] / 255.0);
+        }
+        const double n = glm::max(texels, 1);
+        table[m] = vec4(vec3(albedo / (n * 6.2831853)), 0.0f);
+        table[LPV_MATERIALS + m] = vec4(vec3(100.0 * emission / n), 0.0f);
+    }
+    volume.init(nullptr, 0, binding);
+    volume.upload(nullptr, LPV_BYTES);
+    volume.update(table, sizeof(table));
+    reset = true;
+}
+
+void RadianceVolume::uniforms(ComputeShader& shader){
+    shader.setUniformInt("lpv_parity", parity);
+    shader.setUniformFloat("lpv_cell", LPV_CELL);
+    for(int c = 0; c < LPV_CASCADES; ++c){
+        shader.setUniform("lpv_origin[" + std::to_string(c) + "]", origin[c]);
+    }
+}
+
+void RadianceVolume::update(SDF_Edits& edits, const vec3& eye){
+    if(!enabled)
+        return;
+    if(commits != edits.committed_version()){
+        commits = edits.committed_version();
+        reset = true;
+    }
+    bool moved = reset;
+    for(int c = 0; c < LPV_CASCADES; ++c){
+        const float h = LPV_CELL * float(1 << c);
+        origin[c] = ivec3(floor(eye / h)) - LPV_SIZE / 2;
+        moved = moved || origin[c] != injected[c];
+    }
+
+    prog.bind();
+    edits.uniform(prog);
+    uniforms(prog);
+    const unsigned groups = LPV_SIZE / 4;
+    if(moved){
+        for(int c = 0; c < LPV_CASCADES; ++c){
+            // a corner a whole cascade away keeps no cell
+            const ivec3 previous = reset ? origin[c] + LPV_SIZE : injected[c];
+            prog.setUniform("lpv_previous[" + std::to_string(c) + "]", previous);
+            injected[c] = origin[c];
+        }
+        prog.setUniformInt("lpv_pass", LPV_INJECT);
+        prog.call(groups, groups, groups * LPV_CASCADES);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        reset = false;
+    }
+    prog.setUniformInt("lpv_pass", LPV_PROPAGATE);
+    for(int i = 0; i < LPV_ITERATIONS; ++i){
+        prog.setUniformInt("lpv_parity", parity);
+        prog.call(groups, groups, groups * LPV_CASCADES);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        parity ^= 1;
+    }
+}
+
+void RadianceVolume::uniform(ComputeShader& shader){
+    shader.setUniformInt("lpv_enabled", enabled ? 1 : 0);
+    uniforms(shader);
+}
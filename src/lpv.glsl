@@ -1,159 +1,83 @@
 #version 430 core
 
-layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
-
-layout(binding=2) uniform CAM_BUF
-{
-    mat4 IVP;
-    vec4 eye;
-    vec4 nfwh;
-    vec4 seed;
-    ivec4 lpvsz_frameid;
-};
-
-#define EYE eye.xyz
-#define NEAR nfwh.x
-#define FAR nfwh.y
-#define WIDTH nfwh.z
-#define HEIGHT nfwh.w
-#define SAMPLES seed.w
-#define LPV_SIZE lpvsz_frameid.x
-#define FRAME_ID lpvsz_frameid.w
-#define LPV_RADIUS eye.w
-
-struct Material{
-    vec4 reflectance, emittance;
-};
-
-layout(binding=3) buffer MAT_BUF{
-    Material materials[];
-};
-#define ROUGHNESS(i) materials[(i)].emittance.w
-
-layout(binding=4) buffer LPV_BUF{
-    vec4 lpv_buf[];
-};
-
-
-vec3 toWorld(float x, float y, float z){
-    vec4 t = vec4(x, y, z, 1.0);
-    t = IVP * t;
-    return vec3(t/t.w);
-}
-
-struct MapSample{
-    float distance;
-    int matid;
-};
+// The two passes over the radiance volume of lpv.h: injection classifies
+// the cells a cascade moved onto against every edit but the brush, and
+// propagation spreads light one cell further from the latest half into
+// the other.
 
-float vmax(vec3 a){
-    return max(max(a.x, a.y), a.z);
-}
-
-MapSample sphere(vec3 ray, vec3 location, float radius, int mat){
-    return MapSample(distance(ray, location) - radius, mat);
-}
-
-MapSample box(vec3 ray, vec3 location, vec3 dimension, int mat){
-    vec3 d = abs(ray - location) - dimension;
-    return MapSample(vmax(d), mat);
-}
-
-MapSample plane(vec3 ray, vec3 location, vec3 normal, int mat){
-    return MapSample(dot(ray - location, normal), mat);
-}
-
-MapSample join(MapSample a, MapSample b){
-    if(a.distance <= b.distance)
-        return a;
-    return b;
-}
-
-float diff(MapSample a, MapSample b){
-    return a.distance - b.distance;
-}
-
-// Repeat in three dimensions
-vec3 tri(inout vec3 p, vec3 size) {
-	vec3 c = floor((p + size*0.5)/size);
-	p = mod(p + size*0.5, size) - size*0.5;
-	return c;
-}
-
-MapSample map(vec3 ray){
-    MapSample a = sphere(ray, // light
-        vec3(0.0f, 0.0f, 0.0f),
-        0.5f,
-        0);
-    MapSample b = sphere(ray,    // red
-        vec3(-1.5f, 0.0f, 0.0f),
-        1.0f,
-        9);
-    a = join(a, b);
-    b = sphere(ray,    // green
-        vec3(0.0f, 1.5f, 0.0f),
-        1.0f,
-        10);
-    a = join(a, b);
-    b = sphere(ray,    // chrome
-        vec3(0.0f, 0.0f, 1.5f),
-        1.0f,
-        8);
-    a = join(a, b);
-    return a;
-}
-
-int getidx(int buf, ivec3 ipos){
-    ipos = clamp(ipos, 0, LPV_SIZE);
-    int idx = ipos.x + ipos.y * LPV_SIZE + ipos.z * LPV_SIZE * LPV_SIZE;
-    idx += LPV_SIZE * LPV_SIZE * LPV_SIZE * (buf & 1);
-    return idx;
-}
-
-vec3 read(int buf, ivec3 ipos){
-    return lpv_buf[getidx(buf, ipos)].xyz;
-}
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
 
-void write(int buf, ivec3 ipos, vec3 val){
-    val = clamp(val, 0.0, 1.0);
-    lpv_buf[getidx(buf, ipos)].xyz = val;
+#include "sdf.glsl"
+#include "lpv_volume.glsl"
+
+#define LPV_INJECT 0
+#define LPV_PROPAGATE 1
+uniform int lpv_pass;
+// lowest corner of each cascade when it was last injected, cells it
+// covered keep their state
+uniform ivec3 lpv_previous[LPV_CASCADES];
+
+// latest radiance of world cell w of cascade c, taken from the coarser
+// cascades past its edge and black past the last
+vec3 lpv_neighbour(int c, ivec3 w){
+    vec3 p = (vec3(w) + 0.5) * lpv_cell_size(c);
+    for(; c < LPV_CASCADES; ++c){
+        const ivec3 v = ivec3(floor(p / lpv_cell_size(c)));
+        if(lpv_inside(c, v))
+            return lpv_read(lpv_parity, c, v);
+    }
+    return vec3(0.0);
 }
 
-vec3 getneighbors(int buf, ivec3 ipos){
-	vec3 sum = vec3(0.0f);
-    sum += read(buf, ipos + ivec3(1, 0, 0));
-    sum += read(buf, ipos + ivec3(-1, 0, 0));
-    sum += read(buf, ipos + ivec3(0, 1, 0));
-    sum += read(buf, ipos + ivec3(0, -1, 0));
-    sum += read(buf, ipos + ivec3(0, 0, 1));
-    sum += read(buf, ipos + ivec3(0, 0, -1));
-	return sum * 0.166666;
-}
-
-vec3 calc(int buf, vec3 pos, ivec3 ipos){
-	MapSample hit = map(pos);
-	if(hit.distance < (LPV_RADIUS * 0.25f)) // occluded, no light
-		return vec3(0.0f);
-
-	vec3 inc = getneighbors(buf, ipos);
-
-	if(hit.distance < LPV_RADIUS) // reflector
-		return inc * materials[hit.matid].reflectance.xyz + vec3(0.1);// materials[hit.matid].emittance.xyz;
-
-	// transmission
-	return inc;
+vec3 lpv_incoming(int c, ivec3 w){
+    vec3 sum = vec3(0.0);
+    for(int k = 0; k < 6; ++k){
+        ivec3 d = ivec3(0);
+        d[k >> 1] = (k & 1) == 0 ? 1 : -1;
+        sum += lpv_neighbour(c, w + d);
+    }
+    return sum / 6.0;
 }
 
+// one thread per stored cell, cascades stacked along z
 void main(){
-    ivec3 ipos = ivec3(gl_GlobalInvocationID.xyz);
-	if(ipos.x >= LPV_SIZE || ipos.y >= LPV_SIZE || ipos.z >= LPV_SIZE)
-		return;
-
-	int a = FRAME_ID & 1;
-	int b = (FRAME_ID + 1) & 1;
-
-	float hsize = float(LPV_SIZE >> 1);
-	vec3 pos = EYE + LPV_RADIUS * (vec3(ipos) - hsize);
-	vec3 outgoing = calc(a, pos, ipos);
-	write(b, ipos, outgoing);
+    const ivec3 id = ivec3(gl_GlobalInvocationID.xyz);
+    const int c = id.z / LPV_SIZE;
+    if(c >= LPV_CASCADES)
+        return;
+    const ivec3 s = ivec3(id.xy, id.z % LPV_SIZE);
+    // the world cell stored at s
+    const ivec3 w = lpv_origin[c] + ((s - lpv_origin[c]) & (LPV_SIZE - 1));
+    const int i = lpv_index(c, w);
+
+    if(lpv_pass == LPV_INJECT){
+        const ivec3 l = w - lpv_previous[c];
+        if(all(greaterThanEqual(l, ivec3(0))) && all(lessThan(l, ivec3(LPV_SIZE))))
+            return;
+        const float h = lpv_cell_size(c);
+        const vec2 sam = sdf_map_first((vec3(w) + 0.5) * h, num_sdfs - 1);
+        // half the diagonal of a cell
+        const float r = 0.87 * h;
+        int state = LPV_FREE;
+        if(sam.x < -r)
+            state = LPV_SOLID;
+        else if(sam.x < r && sam.y >= 0.0){
+            // as depth.glsl maps material ids to textures
+            const int m = sdf_material_id(int(sam.y));
+            state = m == 1 || m == 2 ? m : 0;
+        }
+        lpv_state[i] = state;
+        lpv_radiance[i] = vec4(0.0);
+        lpv_radiance[LPV_CASCADES * LPV_CELLS + i] = vec4(0.0);
+        return;
+    }
+
+    const int state = lpv_state[i];
+    vec3 L = vec3(0.0);
+    if(state != LPV_SOLID){
+        L = lpv_incoming(c, w);
+        if(state >= 0)
+            L = lpv_reflectance[state].rgb * L + lpv_emission[state].rgb;
+    }
+    lpv_radiance[(lpv_parity ^ 1) * LPV_CASCADES * LPV_CELLS + i] = vec4(L, 0.0);
 }
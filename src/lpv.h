@@ -0,0 +1,52 @@
+#ifndef LPV_H
+#define LPV_H
+
+#include "glm/glm.hpp"
+#include "compute_shader.h"
+#include "SSBO.h"
+#include "materials.h"
+
+class SDF_Edits;
+
+// must match lpv_volume.glsl
+#define LPV_SIZE 32
+#define LPV_CASCADES 3
+#define LPV_MATERIALS (MATERIAL_TEXTURE_COUNT / 3)
+// cell size of the first cascade, each after it doubles
+#define LPV_CELL 0.25f
+// propagation steps per frame, each carrying light one cell further
+#define LPV_ITERATIONS 4
+
+/*
+    Clipmap of radiance volumes centred on the camera, read by the path
+    tracers in place of every bounce after the first. lpv.glsl marks the
+    cells on the committed edits with their material, the mean albedo and
+    emission of its maps, and diffuses light between neighbouring cells,
+    the coarser cascades lighting the edges of the finer ones. Cells wrap
+    around each cascade, so when the camera crosses a cell only the slices
+    it exposed are injected; committing or undoing an edit injects all.
+    Like the brick map it leaves out the brush.
+
+    Storage: the material table, the cell states and two halves of
+    radiance, swapped every propagation step, at one ssbo binding.
+*/
+class RadianceVolume{
+    ComputeShader prog;
+    SSBO volume;
+    glm::ivec3 origin[LPV_CASCADES], injected[LPV_CASCADES];
+    unsigned commits;
+    int parity;
+    bool enabled, reset;
+    void uniforms(ComputeShader& shader);
+public:
+    RadianceVolume();
+    void init(unsigned binding);
+    inline void toggle(){ enabled = !enabled; reset = true; }
+    inline bool on()const{ return enabled; }
+    // follows eye, injects what moved into view or what the committed
+    // edits changed and propagates, call after SDF_Edits::upload
+    void update(SDF_Edits& edits, const glm::vec3& eye);
+    void uniform(ComputeShader& shader);
+};
+
+#endif
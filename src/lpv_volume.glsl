@@ -0,0 +1,67 @@
+// Cascaded radiance volume of lpv.h, written by lpv.glsl and read by the
+// path tracers. Each cascade is LPV_SIZE^3 cells around the camera, twice
+// as coarse as the one before; cells are stored by world cell modulo
+// LPV_SIZE, so a moving cascade keeps every cell it still covers.
+
+// must match lpv.h
+#define LPV_SIZE 32
+#define LPV_CASCADES 3
+#define LPV_MATERIALS 3
+#define LPV_CELLS (LPV_SIZE * LPV_SIZE * LPV_SIZE)
+// lpv_state of the cells away from a surface
+#define LPV_FREE -1
+#define LPV_SOLID -2
+
+layout(std430, binding = 17) buffer LPV_BUF
+{
+    vec4 lpv_reflectance[LPV_MATERIALS];    // rgb: mean albedo of each material, over 2pi
+    vec4 lpv_emission[LPV_MATERIALS];       // rgb: mean emission
+    int lpv_state[LPV_CASCADES * LPV_CELLS];    // material of cells on a surface, else LPV_FREE or LPV_SOLID
+    vec4 lpv_radiance[2 * LPV_CASCADES * LPV_CELLS]; // rgb, the half at lpv_parity is the latest
+};
+
+uniform int lpv_enabled;
+uniform int lpv_parity;
+// cell size of the first cascade
+uniform float lpv_cell;
+// world cell at the lowest corner of each cascade
+uniform ivec3 lpv_origin[LPV_CASCADES];
+
+float lpv_cell_size(int c){
+    return lpv_cell * float(1 << c);
+}
+
+int lpv_index(int c, ivec3 w){
+    const ivec3 s = w & (LPV_SIZE - 1);
+    return c * LPV_CELLS + (s.z * LPV_SIZE + s.y) * LPV_SIZE + s.x;
+}
+
+bool lpv_inside(int c, ivec3 w){
+    const ivec3 l = w - lpv_origin[c];
+    return all(greaterThanEqual(l, ivec3(0))) && all(lessThan(l, ivec3(LPV_SIZE)));
+}
+
+vec3 lpv_read(int part, int c, ivec3 w){
+    return lpv_radiance[part * LPV_CASCADES * LPV_CELLS + lpv_index(c, w)].rgb;
+}
+
+// radiance a cell off the surface at p with normal N, trilinear in the
+// finest cascade around it; w is 0 outside every cascade
+vec4 lpv_lookup(vec3 p, vec3 N){
+    for(int c = 0; c < LPV_CASCADES; ++c){
+        const float h = lpv_cell_size(c);
+        const vec3 q = (p + N * h) / h - 0.5;
+        const ivec3 w = ivec3(floor(q));
+        if(!lpv_inside(c, w) || !lpv_inside(c, w + 1))
+            continue;
+        const vec3 f = q - vec3(w);
+        vec3 sum = vec3(0.0);
+        for(int k = 0; k < 8; ++k){
+            const ivec3 o = ivec3(k & 1, (k >> 1) & 1, k >> 2);
+            const vec3 t = mix(1.0 - f, f, vec3(o));
+            sum += t.x * t.y * t.z * lpv_read(lpv_parity, c, w + o);
+        }
+        return vec4(sum, 1.0);
+    }
+    return vec4(0.0);
+}
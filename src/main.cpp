@@ -15,118 +15,32 @@
 #include <random>
 #include "array.h"
 #include "image.h"
-#include <glm/gtx/euler_angles.hpp> 
-
-#define SDF_SPHERE 0
-#define SDF_BOX 1
-#define SDF_PLANE 2
-#define SDF_CONE 3
-#define SDF_PYRAMID 4
-#define SDF_TORUS 5
-#define SDF_CYLINDER 6
-#define SDF_CAPSULE 7
-#define SDF_DISK 8
-#define SDF_TYPE_COUNT 9
-
-#define SDF_BLEND_UNION 0
-#define SDF_BLEND_DIFF 1
-#define SDF_BLEND_INT 2
-#define SDF_BLEND_SMTH_UNION 3
-#define SDF_BLEND_SMTH_DIFF 4
-#define SDF_BLEND_SMTH_INT 5
-#define SDF_BLEND_COUNT 6
-
-#define MATERIAL_COUNT 4
+#include "sdf.h"
+#include "brickmap.h"
+#include "sdf_codegen.h"
+#include "cone.h"
+#include "reprojection.h"
+#include "adaptive.h"
+#include "denoise.h"
+#include "wavefront.h"
+#include "tilequeue.h"
+#include "sequence.h"
+#include "emitters.h"
+#include "lpv.h"
+#include "radiance_cache.h"
+#include "primary_cache.h"
+#include "cpu_tracer.h"
+#include "uniforms.h"
+#include "materials.h"
+#include "benchmark.h"
+#include "offline.h"
+#include <cstring>
+#include <functional>
 
 using namespace std;
 using namespace glm;
 
-struct Uniforms
-{
-    glm::mat4 IVP;
-    glm::vec4 eye;
-    glm::vec4 nfwh;
-    glm::vec4 seed;
-};
-
-struct edit_params
-{
-    vec3 t, r, s;
-    int dis_type, blend_type, mat_id;
-    float smoothness;
-    float uv_scale;
-    edit_params()
-    {
-        dis_type = 0;
-        blend_type = 0;
-        mat_id = 0;
-        smoothness = 0.5f;
-        uv_scale = 1.0f;
-        s = vec3(1.0f);
-    }
-};
-
-class SDF 
-{
-    mat4 inv_xform;
-    vec4 parameters; // [dis_type, blend_type, smoothness, material_id]
-    vec4 extra_params; // [object_id, uv_scale]
-public:
-    SDF(){}
-    SDF(const edit_params& params)
-    {
-        static int id = 0;
-        inv_xform = glm::inverse(
-            glm::translate({}, params.t) *
-            glm::orientate4(params.r) *
-            glm::scale({}, params.s)
-        );
-        parameters = vec4(
-            float(params.dis_type),
-            float(params.blend_type),
-            params.smoothness,
-            float(params.mat_id)
-        );
-        extra_params = vec4(
-            float(id++),
-            params.uv_scale,
-            0.0f,
-            0.0f
-        );
-    }
-};
-
-class SDF_Edits
-{
-    Vector<SDF> sdfs;
-    SSBO ssbo;
-public:
-    void init(int binding)
-    {
-        sdfs.grow();
-        ssbo.init(nullptr, 32 * sizeof(SDF), binding);
-    }
-    void add_edit()
-    {
-        sdfs.grow();
-    }
-    void update_brush(const edit_params& params)
-    {
-        sdfs.back() = SDF(params);
-    }
-    void undo(){
-        if(sdfs.count() > 1)
-        {
-            sdfs.pop();
-        }
-    }
-    void uniform(ComputeShader& shader){
-        shader.setUniformInt("num_sdfs", sdfs.count());
-        ssbo.upload(sdfs.begin(), sdfs.bytes());
-    }
-};
-
-float frameBegin(unsigned& i, float& t)
+float frameBegin(unsigned& i, float& t, const FrameTimers& timers, RadianceCache& cache)
 {
     float dt = (float)glfwGetTime() - t;
     t += dt;
@@ -134,6 +48,9 @@ float frameBegin(unsigned& i, float& t)
     if(t >= 3.0f){
         float ms = (t / i) * 1000.0f;
         printf("ms: %.6f, FPS: %.3f\n", ms, i / t);
+        timers.print();
+        if(cache.on())
+            cache.print();
         i = 0;
         t = 0.0f;
         glfwSetTime(0.0);
@@ -215,14 +132,57 @@ bool editing_behaviour(Input& input, Camera& cam, SDF_Edits& edits)
     return anyEdit;
 }
 
+struct Mode{
+    const char* name;
+    std::function<int(int width, int height)> run;
+    int width, height; // unless given on the command line
+};
+
 int main(int argc, char* argv[])
 {
     srand((unsigned)time(NULL));
+    // modes run instead of the window, as main <name> [width height]
+    const Mode modes[] = {
+        {"codegen", codegen_benchmark, 1280, 720},
+        {"gradient", gradient_benchmark, 1280, 720},
+        {"normals", gradient_check, 1280, 720},
+        {"bricks", brick_benchmark, 320, 180},
+        {"cone", cone_benchmark, 1280, 720},
+        {"bench", [](int width, int height){ return suite_benchmark(width, height, "bench.json"); }, 640, 360},
+        {"adaptive", [=](int width, int height){
+            return adaptive_benchmark(width, height, argc >= 5 ? float(atof(argv[4])) : 0.005f);
+        }, 320, 180},
+        {"denoise", denoise_benchmark, 320, 180},
+        {"wavefront", wavefront_benchmark, 640, 360},
+        {"tiles", tile_benchmark, 640, 360},
+        {"sequence", sequence_benchmark, 320, 180},
+        {"brdf", brdf_benchmark, 320, 180},
+        {"lights", light_benchmark, 320, 180},
+        {"roulette", roulette_benchmark, 320, 180},
+        {"cache", cache_benchmark, 320, 180},
+        {"primary", primary_benchmark, 320, 180},
+        {"reset", reset_benchmark, 320, 180},
+        {"cpu", cpu_benchmark, 320, 180},
+    };
+    if(argc >= 2 && strcmp(argv[1], "render") == 0){
+        return offline_render(argc - 2, argv + 2);
+    }
+    for(const Mode& mode : modes){
+        if(argc >= 2 && strcmp(argv[1], mode.name) == 0){
+            const bool sized = argc >= 4;
+            return mode.run(sized ? atoi(argv[2]) : mode.width, sized ? atoi(argv[3]) : mode.height);
+        }
+    }
+
     int WIDTH = 1920, HEIGHT = 1080;
     if(argc == 3){
         WIDTH = atoi(argv[1]);
         HEIGHT = atoi(argv[2]);
     }
+    else if(argc != 1){
+        fprintf(stderr, "unknown mode %s\n", argv[1]);
+        return 1;
+    }
     
     Camera camera;
     camera.resize(WIDTH, HEIGHT);
@@ -238,17 +198,44 @@ int main(int argc, char* argv[])
     Input input(window.getWindow());
     
     GLProgram color("assets/vert.glsl", "assets/frag.glsl");
-    ComputeShader depth("assets/depth.glsl");
+    SDF_Programs depth_programs("assets/depth.glsl");
+    SDF_Programs cone_programs("assets/cone.glsl");
 
-    Texture4f colTex;
-    colTex.init(WIDTH, HEIGHT);
-    colTex.setCSBinding(0, GL_READ_WRITE);
+    Reprojection reprojection;
+    reprojection.init(WIDTH, HEIGHT);
+    AdaptiveSampler adaptive;
+    adaptive.init(WIDTH, HEIGHT, 9);
+    Wavefront wavefront;
+    TileQueue tile_queue;
+    tile_queue.init(WIDTH, HEIGHT, 14);
+    SampleSequence sequence;
+    sequence.init(15);
+    EmitterList emitters;
+    emitters.init(16);
+    RadianceVolume lpv;
+    lpv.init(17);
+    RadianceCache cache;
+    cache.init(18);
+    PrimaryCache primary;
+    primary.init(WIDTH, HEIGHT, 19);
 
     GLScreen screen;
-    Timer timer;
+    FrameTimers timers;
+    const int bricks_scope = timers.scope("bricks");
+    const int prepass_scope = timers.scope("prepass");
+    const int trace_scope = timers.scope("trace");
+    const int present_scope = timers.scope("present");
+    Denoiser denoiser;
+    denoiser.init(WIDTH, HEIGHT, 10, &timers);
     SDF_Edits edits;
 
-    edits.init(3);
+    edits.init(3, 4, 5);
+
+    BrickMap bricks;
+    bricks.init(1, 2, 3, 6, 7);
+
+    ConePrepass cone;
+    cone.init(WIDTH, HEIGHT, 4);
     
     Uniforms uni;
     uni.IVP = camera.getIVP();
@@ -256,38 +243,21 @@ int main(int argc, char* argv[])
     uni.nfwh = glm::vec4(camera.getNear(), camera.getFar(), (float)WIDTH, (float)HEIGHT);
     UBO unibuf(&uni, sizeof(uni), 2);
 
-    const int num_channels = 3;
-    const int num_textures = num_channels * 3;
+    const int num_textures = MATERIAL_TEXTURE_COUNT;
     int texture_unit_capacity = 0;
     glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &texture_unit_capacity);
     assert(num_textures < texture_unit_capacity);
-    const char* textureFiles[] = {
-        "assets/light_albedo.png",
-        "assets/light_normal.png",
-        "assets/light_specular.png",
-        "assets/wood_albedo.png",
-        "assets/wood_normal.png",
-        "assets/wood_specular.png",
-        "assets/copper_albedo.png",
-        "assets/copper_normal.png",
-        "assets/copper_specular.png"
-    };
-    const char* samplerNames[] = {
-        "albedo0",
-        "normal0",
-        "material0",
-        "albedo1",
-        "normal1",
-        "material1",
-        "albedo2",
-        "normal2",
-        "material2"
-    };
     Texture4uc textures[num_textures];
     for(int i = 0; i < num_textures; ++i){
-        textures[i].init(textureFiles[i]);
+        textures[i].init(material_files[i]);
     }
 
+    bool central_normals = false;
+    bool importance_sampling = true;
+    CPUTracer cpu;
+    bool cpu_enabled = false;
+    bool local_reset = true;
+
     input.poll();
     unsigned i = 0;
     float frame = 1.0f;
@@ -297,33 +267,217 @@ int main(int argc, char* argv[])
     {
         glm::vec3 eye = camera.getEye();
         glm::vec3 at = camera.getAt();
-        input.poll(frameBegin(i, t), camera);
-        if(!v3_equal(eye, camera.getEye()) || !v3_equal(at, camera.getAt()))
+        input.poll(frameBegin(i, t, timers, cache), camera);
+        // reprojection keeps the history across camera motion, the cpu tracer does not
+        const bool moved = !v3_equal(eye, camera.getEye()) || !v3_equal(at, camera.getAt());
+        if(moved && (!reprojection.on() || cpu_enabled))
             frame = 2.0f;
         
-        if(editing_behaviour(input, camera, edits))
-        {
-            frame = 2.0f;
+        const bool edited = editing_behaviour(input, camera, edits);
+
+        for(int* k = input.beginDownKeys(); k != input.endDownKeys(); ++k){
+            if(*k == GLFW_KEY_B){
+                bricks.toggle();
+                printf("brick cache: %s\n", bricks.on() ? "on" : "off");
+                // the bricks' field converges a little off the exact one
+                primary.clear();
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_G){
+                depth_programs.toggle();
+                cone_programs.toggle();
+                wavefront.toggle_programs();
+                printf("generated programs: %s\n", depth_programs.on() ? "on" : "off");
+            }
+            if(*k == GLFW_KEY_C){
+                cone.toggle();
+                printf("cone prepass: %s\n", cone.on() ? "on" : "off");
+            }
+            if(*k == GLFW_KEY_X){
+                cpu_enabled = !cpu_enabled;
+                if(cpu_enabled && !cpu.thread_count())
+                    cpu.init(WIDTH, HEIGHT);
+                printf("backend: %s\n", cpu_enabled ? "cpu" : "gpu");
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_R){
+                reprojection.toggle();
+                printf("reprojection: %s\n", reprojection.on() ? "on" : "off");
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_V){
+                adaptive.toggle();
+                printf("adaptive sampling: %s\n", adaptive.on() ? "on" : "off");
+            }
+            if(*k == GLFW_KEY_F){
+                denoiser.toggle();
+                printf("denoiser: %s\n", denoiser.on() ? "on" : "off");
+                // adaptive frames only write the G-buffer of the pixels they trace
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_T){
+                wavefront.toggle();
+                // 128 bytes of ray state per pixel, only allocated when used
+                if(wavefront.on() && !wavefront.allocated())
+                    wavefront.init(WIDTH, HEIGHT, 11, 12);
+                printf("tracer: %s\n", wavefront.on() ? "wavefront" : "megakernel");
+            }
+            if(*k == GLFW_KEY_P){
+                tile_queue.toggle();
+                printf("persistent threads: %s, %u workgroups\n", tile_queue.on() ? "on" : "off", tile_queue.group_count());
+            }
+            if(*k == GLFW_KEY_O){
+                tile_queue.set_order(tile_queue.get_order() + 1);
+                printf("tile order: %s\n", TileQueue::order_name(tile_queue.get_order()));
+            }
+            if(*k == GLFW_KEY_Q){
+                sequence.set_mode(sequence.get_mode() + 1);
+                printf("sample sequence: %s\n", SampleSequence::mode_name(sequence.get_mode()));
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_I){
+                importance_sampling = !importance_sampling;
+                printf("brdf sampling: %s\n", importance_sampling ? "importance" : "uniform hemisphere");
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_L){
+                emitters.toggle();
+                printf("light sampling: %s\n", emitters.on() ? "on" : "off");
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_J){
+                lpv.toggle();
+                printf("radiance volume: %s\n", lpv.on() ? "on" : "off");
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_H){
+                cache.toggle();
+                printf("radiance cache: %s\n", cache.on() ? "on" : "off");
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_U){
+                primary.toggle();
+                printf("primary hit cache: %s\n", primary.on() ? "on" : "off");
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_M){
+                local_reset = !local_reset;
+                printf("edits reset: %s\n", local_reset ? "the pixels they cover" : "everything");
+            }
+            if(*k == GLFW_KEY_K){
+                uni.limits.w = !uni.limits.w;
+                printf("russian roulette: %s\n", uni.limits.w ? "on" : "off");
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_7 || *k == GLFW_KEY_8){
+                uni.limits.x = glm::clamp(uni.limits.x + (*k == GLFW_KEY_8 ? 1 : -1), 1, PATH_MAX_BOUNCES);
+                printf("bounces: %d\n", uni.limits.x);
+                cache.clear();
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_9 || *k == GLFW_KEY_0){
+                uni.limits.y = glm::clamp(uni.limits.y + (*k == GLFW_KEY_0 ? 10 : -10), 10, 200);
+                printf("march steps: %d\n", uni.limits.y);
+                cache.clear();
+                // cached stalls are where the old step budget ran out
+                primary.clear();
+                frame = 2.0f;
+            }
+            if(*k == GLFW_KEY_N){
+                central_normals = !central_normals;
+                printf("normals: %s\n", central_normals ? "central differences" : "dual numbers");
+                frame = 2.0f;
+            }
+        }
+
+        edits.upload();
+        // an edit resets the pixels that see it, or all of them when it
+        // reaches too far
+        if(edited){
+            const SDF_Change& change = edits.uploaded_change();
+            if(!local_reset || cpu_enabled || change.everywhere || !reprojection.reset(change.region, camera.getIVP()))
+                frame = 2.0f;
         }
+        emitters.update(edits);
+        lpv.update(edits, camera.getEye());
+        cache.update(edits);
+        timers.begin(bricks_scope);
+        bricks.update(edits);
+        timers.end(bricks_scope);
 
         uni.IVP = camera.getIVP();
         uni.eye = glm::vec4(camera.getEye(), 1.0f);
         uni.seed = glm::vec4(rand() * irm, rand() * irm, rand() * irm, frame);
         unibuf.upload(&uni, sizeof(uni));
+        reprojection.next(uni.IVP, camera.getEye());
+        primary.update(edits, uni.IVP);
         
-        depth.bind();
-        for(int i = 0; i < num_textures; ++i){
-            textures[i].bind(4 + i, samplerNames[i], depth);
+        if(cpu_enabled){
+            cpu.render(edits, uni);
+            timers.begin(trace_scope);
+            reprojection.color().upload(cpu.accumulation());
+            timers.end(trace_scope);
+        }
+        else{
+            timers.begin(prepass_scope);
+            cone.run(cone_programs.select(edits), edits, bricks, 13);
+            timers.end(prepass_scope);
+
+            timers.begin(trace_scope);
+            // a moving camera needs every pixel traced, and so do the
+            // pixels an edit reset
+            const bool adaptive_frame = adaptive.on() && !moved && frame > 2.0f && !reprojection.resetting();
+            if(adaptive_frame)
+                adaptive.update();
+            const bool history = frame > 2.0f;
+            auto setup = [&](ComputeShader& prog){
+                for(int i = 0; i < num_textures; ++i){
+                    textures[i].bind(4 + i, material_samplers[i], prog);
+                }
+                edits.uniform(prog);
+                bricks.uniform(prog, 13);
+                cone.uniform(prog);
+                prog.setUniformInt("central_normals", central_normals);
+                prog.setUniformInt("uniform_hemisphere", !importance_sampling);
+                reprojection.uniform(prog, history);
+                denoiser.uniform(prog);
+                sequence.uniform(prog);
+                lpv.uniform(prog);
+                cache.uniform(prog);
+                primary.uniform(prog);
+            };
+            if(wavefront.on()){
+                wavefront.trace(edits, setup, adaptive_frame ? &adaptive : nullptr);
+            }
+            else{
+                ComputeShader& depth = depth_programs.select(edits);
+                depth.bind();
+                setup(depth);
+                if(adaptive_frame)
+                    adaptive.trace(depth);
+                else if(tile_queue.on())
+                    tile_queue.dispatch(depth);
+                else
+                    depth.call(callsizeX, callsizeY, 1);
+            }
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+            timers.end(trace_scope);
+
+            if(denoiser.on())
+                denoiser.run(reprojection);
         }
-        edits.uniform(depth);
-        depth.call(callsizeX, callsizeY, 1);
-        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
         
+        timers.begin(present_scope);
         color.bind();
-        colTex.bind(0, "color", color);
+        if(denoiser.on() && !cpu_enabled)
+            denoiser.output().bind(0, "color", color);
+        else
+            reprojection.color().bind(0, "color", color);
         screen.draw();
+        timers.end(present_scope);
         
         window.swap();
+        timers.endFrame();
         if(frame < 10000000.0f){
             frame++;
         }
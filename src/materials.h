@@ -0,0 +1,32 @@
+#ifndef MATERIALS_H
+#define MATERIALS_H
+
+// albedo, normal and material maps of each material, in the order depth.glsl
+// indexes them by material id
+#define MATERIAL_TEXTURE_COUNT 9
+
+static const char* const material_files[MATERIAL_TEXTURE_COUNT] = {
+    "assets/light_albedo.png",
+    "assets/light_normal.png",
+    "assets/light_specular.png",
+    "assets/wood_albedo.png",
+    "assets/wood_normal.png",
+    "assets/wood_specular.png",
+    "assets/copper_albedo.png",
+    "assets/copper_normal.png",
+    "assets/copper_specular.png"
+};
+
+static const char* const material_samplers[MATERIAL_TEXTURE_COUNT] = {
+    "albedo0",
+    "normal0",
+    "material0",
+    "albedo1",
+    "normal1",
+    "material1",
+    "albedo2",
+    "normal2",
+    "material2"
+};
+
+#endif
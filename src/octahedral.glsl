@@ -0,0 +1,15 @@
+// unit vectors folded onto the octahedron and flattened into [-1, 1]^2
+
+vec2 oct_encode(vec3 n){
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    if(n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return n.xy;
+}
+
+vec3 oct_decode(vec2 p){
+    vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    if(n.z < 0.0)
+        n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    return normalize(n);
+}
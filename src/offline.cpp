@@ -0,0 +1,259 @@
+#include "offline.h"
+#include "myglheaders.h"
+#include "headless.h"
+#include "camera.h"
+#include "compute_shader.h"
+#include "texture.h"
+#include "UBO.h"
+#include "uniforms.h"
+#include "sdf.h"
+#include "sdf_codegen.h"
+#include "brickmap.h"
+#include "cone.h"
+#include "reprojection.h"
+#include "sequence.h"
+#include "emitters.h"
+#include "lpv.h"
+#include "radiance_cache.h"
+#include "primary_cache.h"
+#include "materials.h"
+#include "scenes.h"
+#include "image.h"
+#include <chrono>
+#include <string>
+#include <cstring>
+
+using namespace glm;
+
+struct RenderSettings
+{
+    const char* scene;
+    const char* name;
+    int samples, width, height, sequence;
+    int bounces, steps;
+    bool roulette, volume, cache, primary;
+    vec3 eye, at;
+    RenderSettings() : scene(nullptr), name("render"), samples(64), width(640), height(360), sequence(SEQUENCE_HASH),
+        bounces(PATH_BOUNCES), steps(PATH_STEPS), roulette(true), volume(false), cache(false), primary(false), eye(-1.0f, 4.0f, 10.0f), at(0.0f){}
+};
+
+static bool parse_settings(int argc, char* argv[], RenderSettings& s)
+{
+    for(int i = 0; i < argc; ++i){
+        const char* a = argv[i];
+        const int left = argc - i - 1;
+        if(strcmp(a, "-n") == 0 && left >= 1){
+            s.samples = atoi(argv[++i]);
+        }
+        else if(strcmp(a, "-size") == 0 && left >= 2){
+            s.width = atoi(argv[++i]);
+            s.height = atoi(argv[++i]);
+        }
+        else if((strcmp(a, "-eye") == 0 || strcmp(a, "-at") == 0) && left >= 3){
+            vec3& v = a[1] == 'e' ? s.eye : s.at;
+            for(int c = 0; c < 3; ++c)
+                v[c] = (float)atof(argv[++i]);
+        }
+        else if(strcmp(a, "-sequence") == 0 && left >= 1){
+            const char* m = argv[++i];
+            s.sequence = strcmp(m, "sobol") == 0 ? SEQUENCE_SOBOL : strcmp(m, "blue") == 0 ? SEQUENCE_BLUE_NOISE : SEQUENCE_HASH;
+        }
+        else if(strcmp(a, "-bounces") == 0 && left >= 1){
+            s.bounces = atoi(argv[++i]);
+        }
+        else if(strcmp(a, "-steps") == 0 && left >= 1){
+            s.steps = atoi(argv[++i]);
+        }
+        else if(strcmp(a, "-roulette") == 0 && left >= 1){
+            s.roulette = strcmp(argv[++i], "off") != 0;
+        }
+        else if(strcmp(a, "-volume") == 0 && left >= 1){
+            s.volume = strcmp(argv[++i], "on") == 0;
+        }
+        else if(strcmp(a, "-cache") == 0 && left >= 1){
+            s.cache = strcmp(argv[++i], "on") == 0;
+        }
+        else if(strcmp(a, "-primary") == 0 && left >= 1){
+            s.primary = strcmp(argv[++i], "on") == 0;
+        }
+        else if(strcmp(a, "-o") == 0 && left >= 1){
+            s.name = argv[++i];
+        }
+        else if(a[0] != '-' && !s.scene){
+            s.scene = a;
+        }
+        else{
+            printf("unknown or incomplete option %s\n", a);
+            return false;
+        }
+    }
+    if(!s.scene || s.samples < 1 || s.width < 1 || s.height < 1 || s.bounces < 1 || s.steps < 1){
+        printf("usage: main render <scene> [-n samples] [-size width height] [-eye x y z] [-at x y z] [-sequence hash|sobol|blue]\n"
+            "    [-bounces n] [-steps n] [-roulette on|off] [-volume on|off]\n"
+            "    [-cache on|off] [-primary on|off] [-o name]\n");
+        return false;
+    }
+    return true;
+}
+
+// matches frag.glsl, rows flipped to top to bottom
+static void tonemap(const vec4* hdr, u8* rgba, int width, int height)
+{
+    for(int y = 0; y < height; ++y){
+        const vec4* src = hdr + (height - 1 - y) * width;
+        u8* dst = rgba + 4 * y * width;
+        for(int x = 0; x < width; ++x){
+            vec3 c = max(vec3(src[x]), vec3(0.0f));
+            c = pow(c / (vec3(1.0f) + c), vec3(1.0f / 2.2f));
+            for(int k = 0; k < 3; ++k)
+                dst[4 * x + k] = u8(clamp(c[k], 0.0f, 1.0f) * 255.0f + 0.5f);
+            dst[4 * x + 3] = 255;
+        }
+    }
+}
+
+int offline_render(int argc, char* argv[])
+{
+    RenderSettings s;
+    if(!parse_settings(argc, argv, s))
+        return 1;
+
+    Headless context(4, 3);
+    printf("renderer: %s\n", glGetString(GL_RENDERER));
+
+    SDF_Edits edits;
+    edits.init(3, 4, 5);
+    if(!load_scene(s.scene, edits))
+        return 1;
+
+    Camera camera;
+    camera.resize(s.width, s.height);
+    camera.setEye(s.eye);
+    camera.lookAt(s.at);
+    camera.update();
+
+    Uniforms uni;
+    uni.IVP = camera.getIVP();
+    uni.eye = vec4(camera.getEye(), 1.0f);
+    uni.nfwh = vec4(camera.getNear(), camera.getFar(), (float)s.width, (float)s.height);
+    uni.limits = ivec4(s.bounces, s.steps, PATH_ROULETTE_START, s.roulette ? 1 : 0);
+    UBO unibuf(&uni, sizeof(uni), 2);
+
+    // the camera never moves, history from the same pixel is enough
+    Reprojection history;
+    history.init(s.width, s.height);
+    history.toggle();
+
+    BrickMap bricks;
+    bricks.init(1, 2, 3, 6, 7);
+    ConePrepass cone;
+    cone.init(s.width, s.height, 4);
+    SampleSequence sequence;
+    sequence.init(15);
+    sequence.set_mode(s.sequence);
+    EmitterList emitters;
+    emitters.init(16);
+    RadianceVolume lpv;
+    lpv.init(17);
+    if(s.volume)
+        lpv.toggle();
+    RadianceCache cache;
+    cache.init(18);
+    if(s.cache)
+        cache.toggle();
+    PrimaryCache primary;
+    primary.init(s.width, s.height, 19);
+    if(s.primary)
+        primary.toggle();
+
+    Texture4uc textures[MATERIAL_TEXTURE_COUNT];
+    for(int i = 0; i < MATERIAL_TEXTURE_COUNT; ++i){
+        textures[i].init(material_files[i]);
+    }
+
+    edits.upload();
+    bricks.update(edits);
+    emitters.update(edits);
+    // nor does the camera, so the volume can settle before the first sample
+    for(int i = 0; i < 2 * LPV_SIZE / LPV_ITERATIONS; ++i)
+        lpv.update(edits, s.eye);
+
+    // the edits never change, so wait for the generated programs up front
+    SDF_Programs depth_programs("assets/depth.glsl");
+    SDF_Programs cone_programs("assets/cone.glsl");
+    const bool generated = edits.count() - 1 <= SDF_CODEGEN_MAX_EDITS;
+    ComputeShader& depth = generated ? depth_programs.specialized(edits) : depth_programs.interpreter();
+    ComputeShader& cone_prog = generated ? cone_programs.specialized(edits) : cone_programs.interpreter();
+
+    const unsigned callsizeX = (s.width + CONE_TILE - 1) / CONE_TILE;
+    const unsigned callsizeY = (s.height + CONE_TILE - 1) / CONE_TILE;
+
+    // fixed seeds so the same command renders the same image
+    srand(1);
+    const float irm = 1.0f / RAND_MAX;
+    typedef std::chrono::steady_clock clock;
+    clock::time_point begin = clock::now();
+    double first_ms = 0.0;
+    for(int i = 0; i < s.samples; ++i){
+        uni.seed = vec4(rand() * irm, rand() * irm, rand() * irm, float(i + 1));
+        unibuf.upload(&uni, sizeof(uni));
+        history.next(uni.IVP, s.eye);
+        cache.update(edits);
+        primary.update(edits, uni.IVP);
+
+        cone.run(cone_prog, edits, bricks, 13);
+        depth.bind();
+        for(int t = 0; t < MATERIAL_TEXTURE_COUNT; ++t){
+            textures[t].bind(4 + t, material_samplers[t], depth);
+        }
+        edits.uniform(depth);
+        bricks.uniform(depth, 13);
+        cone.uniform(depth);
+        depth.setUniformInt("central_normals", 0);
+        history.uniform(depth, i > 0);
+        sequence.uniform(depth);
+        lpv.uniform(depth);
+        cache.uniform(depth);
+        primary.uniform(depth);
+        depth.call(callsizeX, callsizeY, 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        // the first sample includes the driver compiling the programs
+        if(i == 0){
+            glFinish();
+            const clock::time_point now = clock::now();
+            first_ms = std::chrono::duration<double, std::milli>(now - begin).count();
+            begin = now;
+        }
+    }
+    glFinish();
+    const double ms = std::chrono::duration<double, std::milli>(clock::now() - begin).count();
+
+    printf("%d edits, %d samples at %dx%d, %s programs\n", edits.count(), s.samples, s.width, s.height,
+        generated ? "generated" : "interpreter");
+    printf("first sample %.1f ms", first_ms);
+    if(s.samples > 1){
+        const double per_sample = ms / (s.samples - 1);
+        printf(", then %.3f ms per sample, %.2f Mpixel samples/s", per_sample,
+            double(s.width) * s.height / (per_sample * 1000.0));
+    }
+    printf("\n");
+    if(cache.on())
+        cache.print();
+
+    Vector<vec4> hdr;
+    hdr.resize(s.width * s.height);
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    history.color().download(hdr.begin());
+
+    const std::string pfm = std::string(s.name) + ".pfm";
+    const std::string png = std::string(s.name) + ".png";
+    write_pfm(pfm.c_str(), &hdr.begin()->x, s.width, s.height);
+
+    Vector<u8> rgba;
+    rgba.resize(4 * s.width * s.height);
+    tonemap(hdr.begin(), rgba.begin(), s.width, s.height);
+    write_png(png.c_str(), rgba.begin(), s.width, s.height);
+    printf("wrote %s and %s\n", png.c_str(), pfm.c_str());
+    return 0;
+}
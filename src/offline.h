@@ -0,0 +1,14 @@
+#ifndef OFFLINE_H
+#define OFFLINE_H
+
+/*
+    main render <scene> [-n samples] [-size width height] [-eye x y z] [-at x y z] [-o name]
+
+    Renders a scene file (see load_scene) in a headless context, accumulating
+    samples without a window, swap or clear, then writes the tonemapped
+    image to name.png and the raw colTex to name.pfm. Prints the time per
+    sample as pure dispatch throughput. Returns the exit code for main.
+*/
+int offline_render(int argc, char* argv[]);
+
+#endif
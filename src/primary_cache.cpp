@@ -0,0 +1,57 @@
+#include "primary_cache.h"
+#include "sdf.h"
+#include "array.h"
+#include "myglheaders.h"
+
+using namespace glm;
+
+PrimaryCache::PrimaryCache()
+    : invalidate("assets/primary_invalidate.glsl"), view(0.0f), width(0), height(0),
+    epoch(1), version(0), enabled(false), allocated(false){
+}
+
+void PrimaryCache::init(int w, int h, unsigned binding){
+    width = w;
+    height = h;
+    hits.init(nullptr, 0, binding);
+}
+
+void PrimaryCache::update(const SDF_Edits& edits, const mat4& IVP){
+    if(!enabled)
+        return;
+    if(!allocated){
+        // epoch 0 is never current
+        Vector<unsigned> zero;
+        zero.resize(width * height * PRIMARY_JITTERS * 2);
+        for(int i = 0; i < zero.count(); ++i)
+            zero[i] = 0;
+        hits.upload(zero.begin(), zero.bytes());
+        allocated = true;
+    }
+    if(IVP != view){
+        view = IVP;
+        ++epoch;
+    }
+    if(edits.version() == version)
+        return;
+    version = edits.version();
+    const SDF_Change& change = edits.uploaded_change();
+    if(change.everywhere){
+        ++epoch;
+    }
+    else if(!change.empty()){
+        invalidate.bind();
+        uniform(invalidate);
+        invalidate.setUniformInt("primary_width", width);
+        invalidate.setUniformInt("primary_height", height);
+        invalidate.setUniform("primary_change_lo", change.region.lo);
+        invalidate.setUniform("primary_change_hi", change.region.hi);
+        invalidate.call((width * height * PRIMARY_JITTERS + 63) / 64, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    }
+}
+
+void PrimaryCache::uniform(ComputeShader& shader){
+    shader.setUniformInt("primary_cache", enabled ? 1 : 0);
+    shader.setUniformInt("primary_epoch", epoch);
+}
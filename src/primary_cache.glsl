@@ -0,0 +1,49 @@
+// First hits of primary_cache.h. While it is on, the primary ray of each
+// frame goes through one of PRIMARY_JITTERS fixed points of its pixel,
+// taken in turn, and the distance its march converged at is kept for that
+// point; later frames start the ray there and the march ends in a step.
+// A march that ran out of steps keeps the distance of its last step
+// instead, which later frames take again alone. Needs CAM_BUF.
+
+// must match primary_cache.h
+#define PRIMARY_JITTERS 8
+// epoch bit of the marches that ran out of steps
+#define PRIMARY_STALLED 0x80000000u
+
+uniform int primary_cache;
+// hits of an older epoch are stale
+uniform int primary_epoch;
+layout(std430, binding = 19) buffer PRIMARY_BUF
+{
+    uvec2 primary_hits[]; // x: distance from the eye as float bits, y: epoch | PRIMARY_STALLED
+};
+
+// the standard 8x multisample pattern, in sixteenths of a pixel from the centre
+const vec2 primary_offsets[PRIMARY_JITTERS] = vec2[](
+    vec2(1.0, -3.0), vec2(-1.0, 3.0), vec2(5.0, 1.0), vec2(-3.0, -5.0),
+    vec2(-5.0, 5.0), vec2(-7.0, -1.0), vec2(3.0, 7.0), vec2(7.0, -7.0));
+
+uint primary_slot(){
+    return uint(seed.w) % uint(PRIMARY_JITTERS);
+}
+
+// this frame's point of every pixel, in pixels from its centre
+vec2 primary_offset(){
+    return primary_offsets[primary_slot()] / 16.0;
+}
+
+// distance from the eye to this frame's first hit of the pixel at
+// y * width + x, negative when it is not cached; stalled when the march
+// is to take the last step of one that ran out of steps
+float primary_lookup(uint pixel, out bool stalled){
+    const uvec2 h = primary_hits[pixel * uint(PRIMARY_JITTERS) + primary_slot()];
+    stalled = (h.y & PRIMARY_STALLED) != 0u;
+    return (h.y & ~PRIMARY_STALLED) == uint(primary_epoch) ? uintBitsToFloat(h.x) : -1.0;
+}
+
+// t is the distance from the eye a converged primary march ended at, or
+// when stalled that of the last step of one that ran out of steps
+void primary_store(uint pixel, float t, bool stalled){
+    primary_hits[pixel * uint(PRIMARY_JITTERS) + primary_slot()] =
+        uvec2(floatBitsToUint(t), uint(primary_epoch) | (stalled ? PRIMARY_STALLED : 0u));
+}
@@ -0,0 +1,47 @@
+#ifndef PRIMARY_CACHE_H
+#define PRIMARY_CACHE_H
+
+#include "glm/glm.hpp"
+#include "compute_shader.h"
+#include "SSBO.h"
+
+class SDF_Edits;
+
+// must match primary_cache.glsl
+#define PRIMARY_JITTERS 8
+
+/*
+    First hits of the primary rays while the camera is still. With it on,
+    each frame's primary rays go through one of PRIMARY_JITTERS fixed
+    points of their pixels in turn instead of a random one, so
+    antialiasing converges to those points, and primary_cache.glsl keeps
+    the distance each point's march converged at. Later frames start the
+    ray at that distance, where the march ends in a step; the hit's normal,
+    uv and edit come from the same evaluations as before. Rays that ran out
+    of steps keep their last step and take only that one again. Moving the
+    camera drops every hit, and primary_invalidate.glsl drops those whose
+    ray crosses what the edits changed, brush included, and every stall.
+
+    Storage: 8 bytes per point of every pixel, allocated when first on.
+*/
+class PrimaryCache{
+    ComputeShader invalidate;
+    SSBO hits;
+    glm::mat4 view;
+    int width, height, epoch;
+    unsigned version;
+    bool enabled, allocated;
+public:
+    PrimaryCache();
+    void init(int width, int height, unsigned binding);
+    inline void toggle(){ enabled = !enabled; ++epoch; }
+    inline bool on()const{ return enabled; }
+    // drops every hit
+    inline void clear(){ ++epoch; }
+    // drops the hits IVP or the edits made stale, call after uploading
+    // CAM_BUF and the edits
+    void update(const SDF_Edits& edits, const glm::mat4& IVP);
+    void uniform(ComputeShader& shader);
+};
+
+#endif
@@ -0,0 +1,56 @@
+#version 430 core
+
+// Drops the cached first hits of primary_cache.glsl whose ray from the eye
+// crosses the region the edits changed, run when they change. Where a
+// march that ran out of steps ends depends on every step it took, so
+// those go whatever changed.
+
+layout(local_size_x = 64) in;
+
+layout(binding=2) uniform CAM_BUF
+{
+    mat4 IVP;
+    vec4 eye;
+    vec4 nfwh;
+    vec4 seed;
+    ivec4 limits;   // bounces, march steps, bounces before roulette, roulette on
+};
+
+#include "primary_cache.glsl"
+
+uniform int primary_width;
+uniform int primary_height;
+uniform vec3 primary_change_lo;
+uniform vec3 primary_change_hi;
+
+void main(){
+    const uint i = gl_GlobalInvocationID.x;
+    const ivec2 size = ivec2(primary_width, primary_height);
+    if(i >= uint(size.x * size.y * PRIMARY_JITTERS))
+        return;
+    const uvec2 h = primary_hits[i];
+    if((h.y & ~PRIMARY_STALLED) != uint(primary_epoch))
+        return;
+    if((h.y & PRIMARY_STALLED) != 0u){
+        primary_hits[i].y = 0u;
+        return;
+    }
+    // the ray of primary_ray through the entry's point of its pixel
+    const uint pixel = i / uint(PRIMARY_JITTERS);
+    const ivec2 pix = ivec2(pixel % uint(size.x), pixel / uint(size.x));
+    const vec2 offset = primary_offsets[i % uint(PRIMARY_JITTERS)] / 16.0;
+    const vec2 uv = (vec2(pix) + offset) / vec2(size) * 2.0 - 1.0;
+    const vec4 p = IVP * vec4(uv, 0.0, 1.0);
+    const vec3 rd = normalize(p.xyz / p.w - eye.xyz);
+
+    // slabs of the changed box along the segment up to a little past the hit
+    const vec3 inv = 1.0 / mix(vec3(1e-8), rd, greaterThan(abs(rd), vec3(1e-8)));
+    const vec3 t0 = (primary_change_lo - eye.xyz) * inv;
+    const vec3 t1 = (primary_change_hi - eye.xyz) * inv;
+    const vec3 near = min(t0, t1);
+    const vec3 far = max(t0, t1);
+    const float enter = max(max(near.x, near.y), max(near.z, 0.0));
+    const float leave = min(min(far.x, far.y), min(far.z, uintBitsToFloat(h.x) + 0.01));
+    if(enter <= leave)
+        primary_hits[i].y = 0u;
+}
@@ -0,0 +1,82 @@
+#include "radiance_cache.h"
+#include "sdf.h"
+#include "array.h"
+#include "myglheaders.h"
+#include <cstdio>
+
+using namespace glm;
+
+// the counters and one CacheCell of radiance_cache.glsl, in unsigned ints
+#define CACHE_COUNTERS 4
+#define CACHE_CELL_UINTS 12
+
+RadianceCache::RadianceCache()
+    : age("assets/radiance_cache_age.glsl"), cells(0), version(0), enabled(false), reset(true){
+}
+
+void RadianceCache::init(unsigned binding, int count){
+    table.init(nullptr, 0, binding);
+    resize(count);
+}
+
+void RadianceCache::resize(int count){
+    cells = count;
+    Vector<unsigned> zero;
+    zero.resize(CACHE_COUNTERS + cells * CACHE_CELL_UINTS);
+    for(int i = 0; i < zero.count(); ++i)
+        zero[i] = 0;
+    table.upload(zero.begin(), zero.bytes());
+    reset = false;
+}
+
+void RadianceCache::update(const SDF_Edits& edits){
+    if(!enabled)
+        return;
+    // an upload that sent nothing new leaves the last change in place
+    const SDF_Change change = edits.version() != version ? edits.uploaded_change() : SDF_Change();
+    version = edits.version();
+    vec3 lo = change.region.lo, hi = change.region.hi;
+    if(reset || change.everywhere){
+        lo = vec3(-1e30f);
+        hi = vec3(1e30f);
+        reset = false;
+    }
+    unsigned occupied = 0;
+    table.update(&occupied, sizeof(occupied), 3 * sizeof(unsigned));
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    age.bind();
+    uniform(age);
+    age.setUniform("cache_change_lo", lo);
+    age.setUniform("cache_change_hi", hi);
+    age.call((cells + 63) / 64, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void RadianceCache::uniform(ComputeShader& shader){
+    shader.setUniformInt("cache_enabled", enabled ? 1 : 0);
+    shader.setUniformInt("cache_cells", cells);
+    shader.setUniformFloat("cache_cell", CACHE_CELL);
+    shader.setUniformFloat("cache_pixels", CACHE_PIXELS);
+    shader.setUniformInt("cache_min_samples", CACHE_MIN_SAMPLES);
+}
+
+RadianceCache::Stats RadianceCache::stats(){
+    unsigned counts[CACHE_COUNTERS];
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    table.read(counts, sizeof(counts));
+    Stats s;
+    s.lookups = counts[0];
+    s.dropped = counts[2];
+    s.hit_rate = counts[0] ? float(counts[1]) / counts[0] : 0.0f;
+    s.occupancy = float(counts[3]) / cells;
+    // occupied is the age pass's to reset
+    counts[0] = counts[1] = counts[2] = 0;
+    table.update(counts, 3 * sizeof(unsigned));
+    return s;
+}
+
+void RadianceCache::print(){
+    const Stats s = stats();
+    printf("radiance cache: %.1f%% of %d cells in use, %.1f%% of %u lookups hit, %u dropped\n",
+        100.0f * s.occupancy, cells, 100.0f * s.hit_rate, s.lookups, s.dropped);
+}
@@ -0,0 +1,126 @@
+// World space hash grid of radiance_cache.h. A path that reaches its
+// second hit looks up the cell there, keyed by position quantized at a
+// power of two size covering a few pixels at its distance from the eye
+// and by the normal's dominant axis; a cell with enough samples ends the path with its mean, any other
+// gets the radiance the rest of the path finds. Needs CAM_BUF and
+// sequence.glsl.
+
+// cells looked at for a key, and cell sizes
+#define CACHE_PROBES 8
+#define CACHE_LEVELS 8
+// fixed point of the sums, and the radiance one sample may add
+#define CACHE_SCALE 256.0
+#define CACHE_MAX_RADIANCE 4.0
+#define CACHE_EMPTY 0u
+
+struct CacheCell {
+    uvec4 key;      // x: checksum, CACHE_EMPTY when free, y: frames since a path wrote it, z: level
+    uvec4 sum;      // xyz: radiance in fixed point, w: samples
+    ivec4 cell;     // xyz: grid coordinates at its level
+};
+
+layout(std430, binding = 18) buffer CACHE_BUF
+{
+    uint cache_lookups;     // since the host last read them
+    uint cache_hits;
+    uint cache_dropped;     // cells that found every probe taken
+    uint cache_occupied;    // cells in use, counted by radiance_cache_age.glsl
+    CacheCell cache[];
+};
+
+uniform int cache_enabled;
+// cells in the table, a power of two
+uniform int cache_cells;
+// smallest cell size, and the pixels a cell spans at least
+uniform float cache_cell;
+uniform float cache_pixels;
+// samples a cell needs before it ends paths
+uniform int cache_min_samples;
+
+float cache_cell_size(uint level){
+    return cache_cell * exp2(float(level));
+}
+
+// width of a pixel at unit distance from the eye
+float cache_pixel_width(){
+    vec4 a = IVP * vec4(0.0, 0.0, 0.0, 1.0);
+    vec4 b = IVP * vec4(0.0, 2.0 / nfwh.w, 0.0, 1.0);
+    a /= a.w;
+    b /= b.w;
+    return distance(a.xyz, b.xyz) / distance(a.xyz, eye.xyz);
+}
+
+uint cache_hash(ivec3 c, uint tag){
+    return sequence_hash(uint(c.x) ^ sequence_hash(uint(c.y) ^ sequence_hash(uint(c.z) ^ sequence_hash(tag))));
+}
+
+// cell of the table for the surface at p with normal N, -1 when it has
+// none and insert is unset or every probe is taken
+int cache_find(vec3 p, vec3 N, bool insert){
+    const float w = distance(p, eye.xyz) * cache_pixel_width() * cache_pixels;
+    const uint level = uint(clamp(ceil(log2(max(w / cache_cell, 1.0))), 0.0, float(CACHE_LEVELS - 1)));
+    const ivec3 c = ivec3(floor(p / cache_cell_size(level)));
+    const vec3 a = abs(N);
+    const uint axis = a.x > a.y && a.x > a.z ? 0u : (a.y > a.z ? 1u : 2u);
+    const uint side = N[axis] < 0.0 ? 1u : 0u;
+    const uint h = cache_hash(c, (level << 3) | (axis << 1) | side);
+    const uint checksum = sequence_hash(h ^ 0x9e3779b9u) | 1u;
+    const uint m = uint(cache_cells - 1);
+    for(uint k = 0u; k < uint(CACHE_PROBES); ++k){
+        const uint i = (h + k) & m;
+        if(cache[i].key.x == checksum)
+            return int(i);
+    }
+    if(!insert)
+        return -1;
+    for(uint k = 0u; k < uint(CACHE_PROBES); ++k){
+        const uint i = (h + k) & m;
+        const uint prior = atomicCompSwap(cache[i].key.x, CACHE_EMPTY, checksum);
+        if(prior == CACHE_EMPTY){
+            cache[i].key.z = level;
+            cache[i].cell = ivec4(c, 0);
+            return int(i);
+        }
+        if(prior == checksum)
+            return int(i);
+    }
+    atomicAdd(cache_dropped, 1u);
+    return -1;
+}
+
+// mean radiance of cell i, w is 0 while it has too few samples
+vec4 cache_radiance(int i){
+    const uvec4 sum = cache[i].sum;
+    if(sum.w < uint(max(cache_min_samples, 1)))
+        return vec4(0.0);
+    return vec4(vec3(sum.xyz) / (CACHE_SCALE * float(sum.w)), 1.0);
+}
+
+// adds L leaving the surface of cell i as one sample
+void cache_add(int i, vec3 L){
+    const uvec3 q = uvec3(clamp(L, 0.0, CACHE_MAX_RADIANCE) * CACHE_SCALE + 0.5);
+    atomicAdd(cache[i].sum.x, q.x);
+    atomicAdd(cache[i].sum.y, q.y);
+    atomicAdd(cache[i].sum.z, q.z);
+    atomicAdd(cache[i].sum.w, 1u);
+    cache[i].key.y = 0u;
+}
+
+// radiance the rest of a path found past the cell it left col and mask at
+vec3 cache_path_radiance(vec3 col_end, vec3 col, vec3 mask){
+    return mix(vec3(0.0), (col_end - col) / max(mask, vec3(1e-6)), greaterThan(mask, vec3(0.0)));
+}
+
+// looks up the cell of a path's second hit at p: L gets its radiance and
+// a w of 1 when the path can end there, else the cell to add the rest of
+// the path to is returned, -1 when the table has no room
+int cache_visit(vec3 p, vec3 N, out vec4 L){
+    atomicAdd(cache_lookups, 1u);
+    const int i = cache_find(p, N, true);
+    L = i < 0 ? vec4(0.0) : cache_radiance(i);
+    if(L.w > 0.0){
+        atomicAdd(cache_hits, 1u);
+        return -1;
+    }
+    return i;
+}
@@ -0,0 +1,61 @@
+#ifndef RADIANCE_CACHE_H
+#define RADIANCE_CACHE_H
+
+#include "compute_shader.h"
+#include "SSBO.h"
+
+class SDF_Edits;
+
+// must match radiance_cache.glsl and radiance_cache_age.glsl
+#define CACHE_MAX_AGE 64
+#define CACHE_MAX_SAMPLES 1024
+// default table size, a power of two
+#define CACHE_CELLS (1 << 18)
+// smallest cell size, and the pixels a cell spans at least at its distance
+#define CACHE_CELL 0.05f
+#define CACHE_PIXELS 8.0f
+#define CACHE_MIN_SAMPLES 16
+
+/*
+    Spatial hash of the radiance leaving surfaces, in world space cells
+    that double in size as they get further from the eye so each spans a
+    few pixels, for ending paths at their second hit. Paths that pass through a cell without enough samples yet add the
+    radiance they find beyond it with atomics, see radiance_cache.glsl.
+    Once a frame the cells no path touched for CACHE_MAX_AGE frames, and
+    those near what the edits changed, brush included, are freed.
+
+    Counts lookups, hits and the cells in use for sizing the table, read
+    back by stats.
+
+    Storage: the counters and the cells at one ssbo binding.
+*/
+class RadianceCache{
+    ComputeShader age;
+    SSBO table;
+    int cells;
+    unsigned version;
+    bool enabled, reset;
+public:
+    struct Stats{
+        float occupancy;    // of the cells, at the last update
+        float hit_rate;     // of the lookups since the last call
+        unsigned lookups, dropped;
+    };
+    RadianceCache();
+    void init(unsigned binding, int cells = CACHE_CELLS);
+    // an empty table of cells, a power of two
+    void resize(int cells);
+    inline void toggle(){ enabled = !enabled; reset = true; }
+    inline bool on()const{ return enabled; }
+    // drops every cell, for changes to the paths such as their bounces
+    inline void clear(){ reset = true; }
+    inline int cell_count()const{ return cells; }
+    // ages the cells, call after SDF_Edits::upload
+    void update(const SDF_Edits& edits);
+    void uniform(ComputeShader& shader);
+    // waits for the gpu
+    Stats stats();
+    void print();
+};
+
+#endif
@@ -0,0 +1,51 @@
+#version 430 core
+
+// Once a frame over every cell of radiance_cache.glsl: frees the cells no
+// path wrote for CACHE_MAX_AGE frames and those the edits changed, halves
+// the sums of cells past CACHE_MAX_SAMPLES so they follow changes in the
+// light, and counts the rest.
+
+layout(local_size_x = 64) in;
+
+layout(binding=2) uniform CAM_BUF
+{
+    mat4 IVP;
+    vec4 eye;
+    vec4 nfwh;
+    vec4 seed;
+    ivec4 limits;   // bounces, march steps, bounces before roulette, roulette on
+};
+
+#include "sequence.glsl"
+#include "radiance_cache.glsl"
+
+// must match radiance_cache.h
+#define CACHE_MAX_AGE 64u
+#define CACHE_MAX_SAMPLES 1024u
+
+// region the last upload of the edits changed, empty when lo > hi
+uniform vec3 cache_change_lo;
+uniform vec3 cache_change_hi;
+
+void main(){
+    const uint i = gl_GlobalInvocationID.x;
+    if(i >= uint(cache_cells))
+        return;
+    const CacheCell c = cache[i];
+    if(c.key.x == CACHE_EMPTY)
+        return;
+    // a cell's light comes from around it, so a change a cell away counts
+    const float h = cache_cell_size(c.key.z);
+    const vec3 lo = vec3(c.cell.xyz - 1) * h;
+    const vec3 hi = vec3(c.cell.xyz + 2) * h;
+    const bool changed = all(lessThanEqual(lo, cache_change_hi)) && all(greaterThanEqual(hi, cache_change_lo));
+    if(changed || c.key.y >= CACHE_MAX_AGE){
+        cache[i].key = uvec4(CACHE_EMPTY, 0u, 0u, 0u);
+        cache[i].sum = uvec4(0u);
+        return;
+    }
+    atomicAdd(cache_occupied, 1u);
+    cache[i].key.y = c.key.y + 1u;
+    if(c.sum.w > CACHE_MAX_SAMPLES)
+        cache[i].sum = c.sum / 2u;
+}
@@ -0,0 +1,75 @@
+#include "reprojection.h"
+
+void Reprojection::init(int w, int h){
+    width = w;
+    height = h;
+    for(int i = 0; i < 2; ++i){
+        colors[i].init(width, height);
+        hits[i].init(width, height);
+    }
+    VP = prev_VP = glm::mat4(1.0f);
+    eye = prev_eye = glm::vec3(0.0f);
+    bind();
+}
+
+void Reprojection::bind(){
+    colors[current].setCSBinding(0, GL_READ_WRITE);
+    colors[current ^ 1].setCSBinding(5, GL_READ_ONLY);
+    hits[current].setCSBinding(6, GL_WRITE_ONLY);
+    hits[current ^ 1].setCSBinding(7, GL_READ_ONLY);
+}
+
+void Reprojection::next(const glm::mat4& IVP, const glm::vec3& new_eye){
+    current ^= 1;
+    prev_VP = VP;
+    prev_eye = eye;
+    VP = glm::inverse(IVP);
+    eye = new_eye;
+    reset_rect = pending_reset;
+    pending_reset = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+    bind();
+}
+
+bool Reprojection::reset(const AABB& region, const glm::mat4& IVP, float max_area){
+    if(region.empty())
+        return true;
+    const glm::vec3 extent = region.extent();
+    const AABB box = region.expanded(RESET_REACH * glm::max(extent.x, glm::max(extent.y, extent.z)));
+    const glm::mat4 view = glm::inverse(IVP);
+    glm::vec2 lo(1e30f), hi(-1e30f);
+    for(int i = 0; i < 8; ++i){
+        const glm::vec3 corner(i & 1 ? box.hi.x : box.lo.x, i & 2 ? box.hi.y : box.lo.y, i & 4 ? box.hi.z : box.lo.z);
+        const glm::vec4 clip = view * glm::vec4(corner, 1.0f);
+        if(clip.w <= 0.0f)
+            return false;
+        const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        lo = glm::min(lo, ndc);
+        hi = glm::max(hi, ndc);
+    }
+    // a pixel away for the jitter and the reprojection's bilinear taps
+    const glm::vec2 size(width, height);
+    lo = glm::floor((lo * 0.5f + 0.5f) * size) - 1.0f;
+    hi = glm::ceil((hi * 0.5f + 0.5f) * size) + 1.0f;
+    // off the image too, its light reaches what is on it
+    if((hi.x - lo.x) * (hi.y - lo.y) > max_area * size.x * size.y)
+        return false;
+    lo = glm::max(lo, glm::vec2(0.0f));
+    hi = glm::min(hi, size - 1.0f);
+    if(lo.x > hi.x || lo.y > hi.y)
+        return true;
+    // several changes before a frame reset the rectangle around them all
+    if(pending_reset.x <= pending_reset.z){
+        lo = glm::min(lo, glm::vec2(pending_reset));
+        hi = glm::max(hi, glm::vec2(pending_reset.z, pending_reset.w));
+    }
+    pending_reset = glm::vec4(lo, hi);
+    return true;
+}
+
+void Reprojection::uniform(ComputeShader& shader, bool history){
+    shader.setUniformInt("reproject", enabled ? 1 : 0);
+    shader.setUniformInt("history", history ? 1 : 0);
+    shader.setUniform("prev_VP", prev_VP);
+    shader.setUniform("prev_eye", prev_eye);
+    shader.setUniform("reset_rect", reset_rect);
+}
@@ -0,0 +1,61 @@
+#ifndef REPROJECTION_H
+#define REPROJECTION_H
+
+#include "compute_shader.h"
+#include "texture.h"
+#include "aabb.h"
+
+// a changed region also resets this many times its largest half extent
+// around it, for the shadows and light it throws there
+#define RESET_REACH 1.0f
+// the share of the image past which a changed region resets all of it
+#define RESET_MAX_AREA 0.25f
+
+/*
+    Accumulation history of depth.glsl. The color and sample count of each
+    pixel, and its first hit (octahedral normal and distance from the eye)
+    with the second moment of its luminance, are written to one pair of
+    images while the previous frame's pair is read, and the pairs swap
+    every frame. With reprojection on, each pixel's hit is projected into
+    the previous frame and its history kept when the depth and normal
+    there agree, so the sample count in alpha survives camera motion.
+    Off, history is read from the same pixel.
+
+    An edit only resets the pixels its region covers, see reset; the
+    light it changes further off is left to converge from the history.
+
+    Images: color 0, previous color 5, hits 6, previous hits 7.
+*/
+class Reprojection{
+    Texture4f colors[2], hits[2];
+    glm::mat4 VP, prev_VP;
+    glm::vec3 eye, prev_eye;
+    // pixels x0 y0 x1 y1 inclusive that drop their history on the next
+    // frame and this one, empty when x0 > x1
+    glm::vec4 pending_reset, reset_rect;
+    int width, height, current;
+    bool enabled;
+    void bind();
+public:
+    Reprojection() : pending_reset(1.0f, 1.0f, 0.0f, 0.0f), reset_rect(1.0f, 1.0f, 0.0f, 0.0f),
+        width(0), height(0), current(0), enabled(true){}
+    void init(int width, int height);
+    inline void toggle(){ enabled = !enabled; }
+    inline bool on()const{ return enabled; }
+    // swaps the pairs and remembers the camera of the frame to be traced
+    void next(const glm::mat4& IVP, const glm::vec3& eye);
+    // drops the history of the pixels that see region, grown by
+    // RESET_REACH, in the view of IVP on the next frame; false when that
+    // covers more than max_area of the image or reaches behind the eye,
+    // and all of it should go instead
+    bool reset(const AABB& region, const glm::mat4& IVP, float max_area = RESET_MAX_AREA);
+    // whether this frame drops the history of some pixels
+    inline bool resetting()const{ return reset_rect.x <= reset_rect.z; }
+    // history is false on the frame after a reset
+    void uniform(ComputeShader& shader, bool history);
+    // the accumulation written this frame
+    inline Texture4f& color(){ return colors[current]; }
+    inline Texture4f& first_hits(){ return hits[current]; }
+};
+
+#endif
@@ -0,0 +1,73 @@
+// The scene as seen by the tracing passes: the committed edits, from the
+// brick cache when it is enabled, with the brush blended on top.
+
+#include "sdf.glsl"
+#include "sdf_committed.glsl"
+#include "brick.glsl"
+
+uniform int brick_enabled;
+layout(binding = 1, rg32f) uniform readonly image3D brick_grid;
+layout(binding = 2, r32i) uniform readonly iimage3D brick_ids;
+uniform sampler3D brick_distances;
+
+// the committed edits, read from the brick cache where it covers p
+vec2 brick_map(vec3 p){
+    const vec3 g = (p - brick_origin.xyz) / brick_origin.w;
+    const ivec3 cell = ivec3(floor(g));
+    if(any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(cell, brick_dims)))
+        return sdf_map_committed(p);
+
+    const vec2 c = imageLoad(brick_grid, cell).xy;
+    const int brick = int(c.y);
+    if(brick == BRICK_LIVE)
+        return sdf_map_committed(p);
+    if(brick == BRICK_EMPTY){
+        // the field changes no faster than the distance to the cell centre
+        const float r = length(p - brick_cell_center(cell));
+        return vec2(c.x > 0.0 ? c.x - r : c.x + r, -1.0);
+    }
+
+    const vec3 f = clamp(g - vec3(cell), 0.0, 1.0) * float(BRICK_SAMPLES - 1);
+    const ivec3 offset = brick_atlas_offset(brick);
+    const vec3 uvw = (vec3(offset) + 0.5 + f) / vec3(textureSize(brick_distances, 0));
+    return vec2(
+        texture(brick_distances, uvw).x,
+        float(imageLoad(brick_ids, offset + ivec3(round(f))).x));
+}
+
+// the brush is always the last edit, so blending it over the committed
+// edits completes the same fold as sdf_map
+vec2 scene_map(vec3 p){
+    const int brush = num_sdfs - 1;
+    const vec2 committed = brick_enabled != 0 ? brick_map(p) : sdf_map_committed(p);
+    return sdf_blend(brush, committed, sdf_distance(brush, p));
+}
+
+SDFDual scene_map_dual(vec3 p){
+    const int brush = num_sdfs - 1;
+    return sdf_blend_dual(brush, sdf_map_committed_dual(p), sdf_distance_dual(brush, p));
+}
+
+uniform int central_normals;
+
+// normalized, or 0 where the field has no gradient, as at the points far
+// past every edit that rays out of steps can end at
+vec3 scene_normalize(vec3 g){
+    const float l = length(g);
+    return l > 0.0 ? g / l : vec3(0.0);
+}
+
+vec3 scene_map_normal(vec3 point){
+    if(brick_enabled == 0 && central_normals == 0)
+        return scene_normalize(scene_map_dual(point).g);
+
+    // cached samples are taken half a sample apart, finer offsets only see
+    // the filtering's flat facets
+    const float h = brick_enabled != 0 ? 0.5 * brick_origin.w / float(BRICK_SAMPLES - 1) : 0.0001;
+    vec3 e = vec3(h, 0.0, 0.0);
+    return scene_normalize(vec3(
+        scene_map(point + e.xyz).x - scene_map(point - e.xyz).x,
+        scene_map(point + e.zxy).x - scene_map(point - e.zxy).x,
+        scene_map(point + e.zyx).x - scene_map(point - e.zyx).x
+    ));
+}
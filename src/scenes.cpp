@@ -0,0 +1,128 @@
+#include "scenes.h"
+#include "sdf.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+void random_scene(SDF_Edits& edits, int count)
+{
+    srand(1);
+    const float irm = 1.0f / RAND_MAX;
+    edit_params ground;
+    ground.dis_type = SDF_PLANE;
+    ground.t = glm::vec3(0.0f, -1.0f, 0.0f);
+    edits.update_brush(ground);
+    for(int i = 1; i < count; ++i){
+        edits.add_edit();
+        edit_params p;
+        p.dis_type = rand() & 1 ? SDF_SPHERE : SDF_BOX;
+        const float b = rand() * irm;
+        p.blend_type = b < 0.6f ? SDF_BLEND_UNION : b < 0.75f ? SDF_BLEND_SMTH_UNION : b < 0.9f ? SDF_BLEND_DIFF : SDF_BLEND_SMTH_DIFF;
+        p.smoothness = 0.05f + 0.3f * rand() * irm;
+        p.t = glm::vec3(rand() * irm * 20.0f - 10.0f, rand() * irm * 2.0f - 0.5f, rand() * irm * 20.0f - 10.0f);
+        p.r = glm::vec3(rand() * irm, rand() * irm, rand() * irm);
+        p.s = glm::vec3(0.2f + 0.6f * rand() * irm);
+        p.mat_id = rand() % 3;
+        edits.update_brush(p);
+    }
+    // the brush
+    edits.add_edit();
+    edits.update_brush(edit_params());
+}
+
+void small_lights_scene(SDF_Edits& edits, int material)
+{
+    srand(2);
+    const float irm = 1.0f / RAND_MAX;
+    edit_params ground;
+    ground.dis_type = SDF_PLANE;
+    ground.t = glm::vec3(0.0f, -1.0f, 0.0f);
+    ground.mat_id = material < 0 ? 1 : material;
+    edits.update_brush(ground);
+    for(int i = 0; i < 24; ++i){
+        edits.add_edit();
+        edit_params p;
+        p.dis_type = i & 1 ? SDF_SPHERE : SDF_BOX;
+        p.t = glm::vec3(rand() * irm * 16.0f - 8.0f, rand() * irm * 1.5f - 0.5f, rand() * irm * 16.0f - 8.0f);
+        p.r = glm::vec3(rand() * irm, rand() * irm, rand() * irm);
+        p.s = glm::vec3(0.4f + 0.6f * rand() * irm);
+        p.mat_id = material < 0 ? 1 + (i & 2) / 2 : material;
+        edits.update_brush(p);
+    }
+    const glm::vec3 lights[] = {
+        glm::vec3(-3.0f, 2.5f, 1.0f), glm::vec3(2.0f, 3.0f, -2.0f), glm::vec3(0.5f, 1.5f, 4.0f) };
+    for(const glm::vec3& t : lights){
+        edits.add_edit();
+        edit_params p;
+        p.t = t;
+        p.s = glm::vec3(0.1f);
+        edits.update_brush(p);
+    }
+    // the brush, out of sight
+    edits.add_edit();
+    edit_params brush;
+    brush.t = glm::vec3(0.0f, -100.0f, 0.0f);
+    brush.mat_id = 1;
+    edits.update_brush(brush);
+}
+
+static int find_name(const char* name, const char* const* names, int count)
+{
+    for(int i = 0; i < count; ++i){
+        if(strcmp(name, names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+bool load_scene(const char* filename, SDF_Edits& edits)
+{
+    if(strncmp(filename, "random:", 7) == 0){
+        random_scene(edits, glm::max(1, atoi(filename + 7)));
+        return true;
+    }
+    if(strcmp(filename, "lights") == 0){
+        small_lights_scene(edits);
+        return true;
+    }
+
+    static const char* const types[SDF_TYPE_COUNT] = {
+        "sphere", "box", "plane", "cone", "pyramid", "torus", "cylinder", "capsule", "disk" };
+    static const char* const blends[SDF_BLEND_COUNT] = {
+        "union", "diff", "int", "smooth_union", "smooth_diff", "smooth_int" };
+
+    FILE* f = fopen(filename, "r");
+    if(!f){
+        printf("could not open %s\n", filename);
+        return false;
+    }
+
+    char line[512];
+    int number = 0, loaded = 0;
+    bool ok = true;
+    while(ok && fgets(line, sizeof(line), f)){
+        ++number;
+        char type[32], blend[32];
+        edit_params p;
+        const int n = sscanf(line, " %31s %31s %d %f %f %f %f %f %f %f %f %f %f %f",
+            type, blend, &p.mat_id, &p.t.x, &p.t.y, &p.t.z, &p.r.x, &p.r.y, &p.r.z,
+            &p.s.x, &p.s.y, &p.s.z, &p.smoothness, &p.uv_scale);
+        if(n <= 0 || type[0] == '#')
+            continue;
+        p.dis_type = find_name(type, types, SDF_TYPE_COUNT);
+        p.blend_type = find_name(blend, blends, SDF_BLEND_COUNT);
+        if(n < 6 || p.dis_type < 0 || p.blend_type < 0 || n == 7 || n == 8 || n == 10 || n == 11){
+            printf("%s:%d: expected type blend material tx ty tz [rx ry rz [sx sy sz [smoothness [uv_scale]]]]\n", filename, number);
+            ok = false;
+            break;
+        }
+        if(loaded++)
+            edits.add_edit();
+        edits.update_brush(p);
+    }
+    fclose(f);
+
+    if(ok && !loaded)
+        printf("%s: no edits\n", filename);
+    return ok && loaded;
+}
@@ -0,0 +1,25 @@
+#ifndef SCENES_H
+#define SCENES_H
+
+class SDF_Edits;
+
+// a ground plane under count random boxes and spheres, mostly unions;
+// the same scene for the same count on every run
+void random_scene(SDF_Edits& edits, int count);
+
+// wood and copper shapes on a wood floor, lit only by three small light
+// spheres; floor and shapes all of material when it is not -1
+void small_lights_scene(SDF_Edits& edits, int material = -1);
+
+/*
+    Reads edits from a text file, one per line:
+        type blend material  tx ty tz  [rx ry rz  [sx sy sz  [smoothness [uv_scale]]]]
+    type is sphere, box, plane, cone, pyramid, torus, cylinder, capsule or disk,
+    blend is union, diff, int, smooth_union, smooth_diff or smooth_int.
+    Blank lines and lines starting with # are skipped. The last edit becomes
+    the brush. "random:N" loads random_scene(N) and "lights"
+    small_lights_scene instead of a file.
+*/
+bool load_scene(const char* filename, SDF_Edits& edits);
+
+#endif
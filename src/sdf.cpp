@@ -0,0 +1,213 @@
+#include "sdf.h"
+#include "compute_shader.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include <glm/gtx/euler_angles.hpp>
+
+using namespace glm;
+
+SDF::SDF(const edit_params& params)
+{
+    static int id = 0;
+    inv_xform = glm::inverse(
+        glm::translate({}, params.t) *
+        glm::orientate4(params.r) *
+        glm::scale({}, params.s)
+    );
+    parameters = vec4(
+        float(params.dis_type),
+        float(params.blend_type),
+        params.smoothness,
+        float(params.mat_id)
+    );
+    extra_params = vec4(
+        float(id++),
+        params.uv_scale,
+        glm::min(fabsf(params.s.x), glm::min(fabsf(params.s.y), fabsf(params.s.z))),
+        0.0f
+    );
+}
+
+float SDF::blend_radius()const
+{
+    switch(blend_type()){
+        case SDF_BLEND_SMTH_UNION:
+        case SDF_BLEND_SMTH_DIFF:
+        case SDF_BLEND_SMTH_INT:
+            return fabsf(smoothness());
+    }
+    return 0.0f;
+}
+
+bool SDF::bounded()const
+{
+    switch(blend_type()){
+        case SDF_BLEND_INT:
+        case SDF_BLEND_SMTH_INT:
+            return false;
+    }
+    switch(distance_type()){
+        case SDF_SPHERE:
+        case SDF_BOX:
+            return true;
+    }
+    return false;
+}
+
+bool SDF::additive()const
+{
+    switch(blend_type()){
+        case SDF_BLEND_UNION:
+        case SDF_BLEND_SMTH_UNION:
+            return true;
+    }
+    return false;
+}
+
+AABB SDF::bounds()const
+{
+    // the bounded primitives all fit in the unit cube before transformation
+    const mat4 xform = glm::inverse(inv_xform);
+    const vec3 c = vec3(xform[3]);
+    const vec3 e = abs(vec3(xform[0])) + abs(vec3(xform[1])) + abs(vec3(xform[2]));
+    return AABB(c - e, c + e);
+}
+
+bool SDF::same_edit(const SDF& o)const
+{
+    return inv_xform == o.inv_xform && parameters == o.parameters &&
+        extra_params.y == o.extra_params.y && extra_params.z == o.extra_params.z;
+}
+
+AABB SDF::influence()const
+{
+    return bounds().expanded(blend_radius() + SDF_BVH_MARGIN);
+}
+
+float SDF::bound_slope()const
+{
+    // no point is further from the box than the largest scale times its
+    // unit space distance, which the box's vmax distance can fall short
+    // of by sqrt(3) at the corners
+    const mat4 xform = glm::inverse(inv_xform);
+    const float s = glm::max(length(vec3(xform[0])), glm::max(length(vec3(xform[1])), length(vec3(xform[2]))));
+    const float corner = distance_type() == SDF_BOX ? 0.57735027f : 1.0f;
+    return corner * distance_scale() / s;
+}
+
+float SDF::bound_offset()const
+{
+    // influence() is padded by the blend radius and the margin, and a
+    // smooth union can pull the field down by a quarter of the radius
+    const float k = blend_radius();
+    return bound_slope() * (k + SDF_BVH_MARGIN) - 0.25f * k;
+}
+
+void SDF_Change::grow(const SDF& sdf)
+{
+    if(sdf.bounded()){
+        region.grow(sdf.influence());
+        slope = glm::min(slope, sdf.bound_slope());
+        offset = glm::min(offset, sdf.bound_offset());
+    }
+    else
+        everywhere = true;
+}
+
+SDF_Edits::SDF_Edits() : changes(0), commits(0), rebuild(true)
+{
+    // the brush
+    sdfs.grow();
+    for(int i = 0; i < SSBO_FRAMES; ++i)
+        dirty[i] = 0;
+}
+
+void SDF_Edits::init(int binding, int bvh_binding, int unbounded_binding)
+{
+    ssbo.initMapped(32 * sizeof(SDF), binding);
+    bvh.init(bvh_binding, unbounded_binding);
+    mark(0);
+    rebuild = true;
+}
+
+void SDF_Edits::mark(int first)
+{
+    ++changes;
+    for(int i = 0; i < SSBO_FRAMES; ++i)
+        dirty[i] = glm::min(dirty[i], first);
+}
+
+void SDF_Edits::add_edit()
+{
+    // the brush becomes a committed edit
+    committed.grow(sdfs.back());
+    // and a copy of it the next brush, which leaves the field as it was
+    const SDF brush = sdfs.back();
+    sdfs.grow() = brush;
+    ++commits;
+    mark(sdfs.count() - 1);
+    rebuild = true;
+}
+
+void SDF_Edits::update_brush(const edit_params& params)
+{
+    const SDF brush(params);
+    // the brush is set every frame, mostly to what it already was
+    if(!brush.same_edit(sdfs.back())){
+        pending.grow(sdfs.back());
+        pending.grow(brush);
+    }
+    sdfs.back() = brush;
+    mark(sdfs.count() - 1);
+    if(!rebuild && !bvh.refit(sdfs.begin(), sdfs.count(), sdfs.count() - 1))
+        rebuild = true;
+}
+
+void SDF_Edits::undo()
+{
+    if(sdfs.count() > 1)
+    {
+        pending.grow(sdfs.back());
+        sdfs.pop();
+        // the last committed edit becomes the brush
+        committed.grow(sdfs.back());
+        ++commits;
+        mark(sdfs.count() - 1);
+        rebuild = true;
+    }
+}
+
+void SDF_Edits::upload()
+{
+    uploaded = pending;
+    pending = SDF_Change();
+    if(rebuild)
+    {
+        bvh.build(sdfs.begin(), sdfs.count());
+        rebuild = false;
+    }
+    if(ssbo.nextFrame(sdfs.bytes()))
+        mark(0);
+    int& first = dirty[ssbo.currentRegion()];
+    if(first < sdfs.count())
+        ssbo.write(sdfs.begin() + first, (sdfs.count() - first) * sizeof(SDF), first * sizeof(SDF));
+    first = sdfs.count();
+    bvh.upload();
+}
+
+void SDF_Edits::uniform(ComputeShader& shader)
+{
+    shader.setUniformInt("num_sdfs", sdfs.count());
+    bvh.uniform(shader);
+}
+
+AABB SDF_Edits::committed_bounds()const
+{
+    AABB box;
+    for(int i = 0; i + 1 < sdfs.count(); ++i)
+    {
+        const SDF& sdf = sdfs[i];
+        if(sdf.bounded())
+            box.grow(sdf.influence());
+    }
+    return box;
+}
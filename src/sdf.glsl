@@ -0,0 +1,459 @@
+#define SDF_SPHERE 0
+#define SDF_BOX 1
+#define SDF_PLANE 2
+#define SDF_CONE 3
+#define SDF_PYRAMID 4
+#define SDF_TORUS 5
+#define SDF_CYLINDER 6
+#define SDF_CAPSULE 7
+#define SDF_DISK 8
+#define SDF_TYPE_COUNT 9
+
+#define SDF_BLEND_UNION 0
+#define SDF_BLEND_DIFF 1
+#define SDF_BLEND_INT 2
+#define SDF_BLEND_SMTH_UNION 3
+#define SDF_BLEND_SMTH_DIFF 4
+#define SDF_BLEND_SMTH_INT 5
+#define SDF_BLEND_COUNT 6
+
+#define MATERIAL_COUNT 4
+
+#define sdf_inv_transform(i) sdfs[i].inv_xform
+#define sdf_distance_type(i) int(sdfs[i].parameters.x)
+#define sdf_blend_type(i) int(sdfs[i].parameters.y)
+#define sdf_blend_smoothness(i) sdfs[i].parameters.z
+#define sdf_material_id(i) int(sdfs[i].parameters.w)
+#define sdf_object_id(i) sdfs[i].extra_params.x
+#define sdf_uv_scale(i) sdfs[i].extra_params.y
+#define sdf_distance_scale(i) sdfs[i].extra_params.z
+
+struct SDF {
+    mat4 inv_xform;
+    vec4 parameters; // [dis_type, blend_type, smoothness, material_id]
+    vec4 extra_params; // [object_id, uv_scale, distance_scale]
+};
+
+layout(binding=3) buffer SDF_BUF {   
+    SDF sdfs[];
+};
+
+struct BVHNode {
+    vec4 lo; // xyz: padded min, w: distance offset of culled additive edits
+    vec4 hi; // xyz: padded max, w: their distance slope, 0 if none
+    ivec4 link; // [left, right, edit index or -1, parent]
+};
+
+layout(binding=4) buffer SDF_BVH_BUF {
+    BVHNode bvh_nodes[];
+};
+
+layout(std430, binding=5) buffer SDF_UNBOUNDED_BUF {
+    int sdf_unbounded[];
+};
+
+uniform int num_sdfs;
+uniform int num_bvh_nodes;
+uniform int num_sdf_unbounded;
+
+#define BVH_STACK_SIZE 32
+#define BVH_MAX_CANDIDATES 32
+
+float vmax(vec3 a){
+    return max(max(a.x, a.y), a.z);
+}
+
+// these rays are all pre-transformed into unit space
+
+vec2 sdf_sphere(int id, vec3 ray){
+    return vec2(length(ray) - 1.0, float(id));
+}
+
+vec2 sdf_box(int id, vec3 ray){
+    vec3 d = abs(ray) - vec3(1.0);
+    return vec2(vmax(d), float(id));
+}
+
+vec2 sdf_plane(int id, vec3 ray){
+    return vec2(dot(ray, vec3(0.0, 1.0, 0.0)), float(id));
+}
+
+// Not Yet Implemented
+vec2 sdf_cone(int id, vec3 ray){
+    return vec2(0.0);   
+}
+
+// Not Yet Implemented
+vec2 sdf_pyramid(int id, vec3 ray){
+    return vec2(0.0);   
+}
+
+// Not Yet Implemented
+vec2 sdf_torus(int id, vec3 ray){
+    return vec2(0.0);   
+}
+
+// Not Yet Implemented
+vec2 sdf_cylinder(int id, vec3 ray){
+    return vec2(0.0);   
+}
+
+// Not Yet Implemented
+vec2 sdf_capsule(int id, vec3 ray){
+    return vec2(0.0);   
+}
+
+// Not Yet Implemented
+vec2 sdf_disk(int id, vec3 ray){
+    return vec2(0.0);   
+}
+
+vec2 sdf_distance(int i, vec3 point){
+    // transform point into unit sphere space
+    vec4 xpoint = sdf_inv_transform(i) * vec4(point.xyz, 1.0);
+    point = (xpoint / xpoint.w).xyz;
+
+    // use unit-sphere sdfs
+    vec2 d;
+    switch(sdf_distance_type(i)){
+        case SDF_SPHERE: d = sdf_sphere(i, point); break;
+        case SDF_BOX: d = sdf_box(i, point); break;
+        case SDF_PLANE: d = sdf_plane(i, point); break;
+        case SDF_CONE: d = sdf_cone(i, point); break;
+        case SDF_PYRAMID: d = sdf_pyramid(i, point); break;
+        case SDF_TORUS: d = sdf_torus(i, point); break;
+        case SDF_CYLINDER: d = sdf_cylinder(i, point); break;
+        case SDF_CAPSULE: d = sdf_capsule(i, point); break;
+        case SDF_DISK: d = sdf_disk(i, point); break;
+        default: return vec2(100000.0, 0.0);
+    }
+
+    // back to world units, so no edit overstates its distance
+    d.x *= sdf_distance_scale(i);
+    return d;
+}
+
+vec2 sdf_blend_union(vec2 a, vec2 b){
+    return a.x < b.x ? a : b;
+}
+
+vec2 sdf_blend_difference(vec2 a, vec2 b){
+    b.x = -b.x;
+    return a.x > b.x ? a : b;
+}
+
+vec2 sdf_blend_intersect(vec2 a, vec2 b){
+    return a.x > b.x ? a : b;
+}
+
+vec2 sdf_blend_smooth_union(vec2 a, vec2 b, float k){
+    float e = max(k - abs(a.x - b.x), 0.0);
+    float dis = min(a.x, b.x) - e * e * 0.25 / k;
+    return vec2(dis, a.x < b.x ? a.y : b.y);
+}
+
+vec2 sdf_blend_smooth_difference(vec2 a, vec2 b, float k){
+    a.x = -a.x;
+    vec2 r = sdf_blend_smooth_union(a, b, k);
+    r.x = -r.x;
+    return r;
+}
+
+vec2 sdf_blend_smooth_intersect(vec2 a, vec2 b, float k){
+    float e = max(k - abs(a.x - b.x), 0.0);
+    float dis = max(a.x, b.x) - e * e * 0.25 / k;
+    return vec2(dis, a.x > b.x ? a.y : b.y);
+}
+
+vec2 sdf_blend(int i, vec2 a, vec2 b){
+    switch(sdf_blend_type(i)){
+        case SDF_BLEND_UNION: return sdf_blend_union(a, b);
+        case SDF_BLEND_DIFF: return sdf_blend_difference(a, b);
+        case SDF_BLEND_INT: return sdf_blend_intersect(a, b);
+        case SDF_BLEND_SMTH_UNION: return sdf_blend_smooth_union(a, b, sdf_blend_smoothness(i));
+        case SDF_BLEND_SMTH_DIFF: return sdf_blend_smooth_difference(a, b, sdf_blend_smoothness(i));
+        case SDF_BLEND_SMTH_INT: return sdf_blend_smooth_intersect(a, b, sdf_blend_smoothness(i));
+    }
+    return sdf_blend_union(a, b);
+}
+
+vec2 sdf_map_linear(vec3 ray, int count){
+    vec2 sam;
+    sam.x = 100000.0;
+    sam.y = -1.0;
+    for(int i = 0; i < count; ++i){
+        sam = sdf_blend(i, sam, sdf_distance(i, ray));
+    }
+    return sam;
+}
+
+// how far a union pulls the field below both of its inputs
+float sdf_union_overlap(int i){
+    return sdf_blend_type(i) == SDF_BLEND_SMTH_UNION ? 0.25 * abs(sdf_blend_smoothness(i)) : 0.0;
+}
+
+float bvh_box_distance(vec3 p, vec3 lo, vec3 hi){
+    return length(max(max(lo - p, p - hi), vec3(0.0)));
+}
+
+// Gathers the edits below count whose padded box contains ray, in edit
+// order. Returns -1 when there are more than BVH_MAX_CANDIDATES.
+int bvh_gather(vec3 ray, int count, out int candidates[BVH_MAX_CANDIDATES]){
+    // sdf_unbounded is already in edit order
+    int num_candidates = 0;
+    for(int i = 0; i < num_sdf_unbounded && sdf_unbounded[i] < count; ++i){
+        candidates[num_candidates++] = sdf_unbounded[i];
+    }
+
+    // the tree depth is log2 of the edit count, so the stack cannot overflow
+    bool overflow = false;
+    int stack[BVH_STACK_SIZE];
+    stack[0] = 0;
+    int sp = 1;
+    while(sp > 0){
+        --sp;
+        const BVHNode node = bvh_nodes[stack[sp]];
+        if(bvh_box_distance(ray, node.lo.xyz, node.hi.xyz) > 0.0)
+            continue;
+        if(node.link.z >= count)
+            continue;
+        if(node.link.z >= 0){
+            if(num_candidates == BVH_MAX_CANDIDATES){
+                overflow = true;
+                break;
+            }
+            // insertion sort keeps the candidates in edit order
+            int j = num_candidates++;
+            while(j > 0 && candidates[j - 1] > node.link.z){
+                candidates[j] = candidates[j - 1];
+                --j;
+            }
+            candidates[j] = node.link.z;
+        }
+        else{
+            stack[sp] = node.link.y;
+            stack[sp + 1] = node.link.x;
+            sp += 2;
+        }
+    }
+    return overflow ? -1 : num_candidates;
+}
+
+// Folds the first count edits. Only the edits whose padded box contains
+// ray are evaluated, in edit order, then the nearest culled additive edit
+// is merged in. Every blend is monotonic in its inputs, so a culled union
+// can be applied last as a lower bound and the result stays a safe sphere
+// tracing step.
+vec2 sdf_map_first(vec3 ray, int count){
+    if(num_bvh_nodes == 0 || num_sdf_unbounded > BVH_MAX_CANDIDATES)
+        return sdf_map_linear(ray, count);
+
+    int candidates[BVH_MAX_CANDIDATES];
+    const int num_candidates = bvh_gather(ray, count, candidates);
+    if(num_candidates < 0)
+        return sdf_map_linear(ray, count);
+
+    vec2 sam;
+    sam.x = 100000.0;
+    sam.y = -1.0;
+    for(int i = 0; i < num_candidates; ++i){
+        const int id = candidates[i];
+        sam = sdf_blend(id, sam, sdf_distance(id, ray));
+    }
+
+    // nearest culled additive edit, pruned by the distance found so far
+    int stack[BVH_STACK_SIZE];
+    stack[0] = 0;
+    int sp = 1;
+    while(sp > 0){
+        --sp;
+        const BVHNode node = bvh_nodes[stack[sp]];
+        const float d = bvh_box_distance(ray, node.lo.xyz, node.hi.xyz);
+        if(node.hi.w <= 0.0 || node.hi.w * d + node.lo.w >= sam.x)
+            continue;
+        if(node.link.z >= 0){
+            if(d > 0.0 && node.link.z < count){
+                vec2 b = sdf_distance(node.link.z, ray);
+                b.x -= sdf_union_overlap(node.link.z);
+                sam = b.x < sam.x ? b : sam;
+            }
+        }
+        else{
+            stack[sp] = node.link.y;
+            stack[sp + 1] = node.link.x;
+            sp += 2;
+        }
+    }
+    return sam;
+}
+
+// Forward mode dual numbers: every distance carries its world space gradient,
+// so a single fold yields the normal.
+
+struct SDFDual {
+    float d;
+    vec3 g;
+    float id;
+};
+
+SDFDual sdf_dual(float d, vec3 g, float id){
+    SDFDual r;
+    r.d = d;
+    r.g = g;
+    r.id = id;
+    return r;
+}
+
+SDFDual sdf_sphere_dual(int id, vec3 ray){
+    const float l = length(ray);
+    return sdf_dual(l - 1.0, ray / max(l, 0.000001), float(id));
+}
+
+SDFDual sdf_box_dual(int id, vec3 ray){
+    const vec3 d = abs(ray) - vec3(1.0);
+    // vmax picks one face, its normal is the gradient
+    vec3 g = vec3(0.0);
+    if(d.x >= d.y && d.x >= d.z)
+        g.x = sign(ray.x);
+    else if(d.y >= d.z)
+        g.y = sign(ray.y);
+    else
+        g.z = sign(ray.z);
+    return sdf_dual(vmax(d), g, float(id));
+}
+
+SDFDual sdf_plane_dual(int id, vec3 ray){
+    return sdf_dual(ray.y, vec3(0.0, 1.0, 0.0), float(id));
+}
+
+// Not Yet Implemented, matches the vec2(0.0) of the plain versions
+SDFDual sdf_unimplemented_dual(){
+    return sdf_dual(0.0, vec3(0.0), 0.0);
+}
+
+// unit space distance to world space, m being the edit's inverse transform
+SDFDual sdf_dual_to_world(SDFDual d, mat3 m, float scale){
+    d.d *= scale;
+    d.g = transpose(m) * d.g * scale;
+    return d;
+}
+
+SDFDual sdf_distance_dual(int i, vec3 point){
+    const mat4 m = sdf_inv_transform(i);
+    vec4 xpoint = m * vec4(point.xyz, 1.0);
+    point = (xpoint / xpoint.w).xyz;
+
+    SDFDual d;
+    switch(sdf_distance_type(i)){
+        case SDF_SPHERE: d = sdf_sphere_dual(i, point); break;
+        case SDF_BOX: d = sdf_box_dual(i, point); break;
+        case SDF_PLANE: d = sdf_plane_dual(i, point); break;
+        case SDF_CONE:
+        case SDF_PYRAMID:
+        case SDF_TORUS:
+        case SDF_CYLINDER:
+        case SDF_CAPSULE:
+        case SDF_DISK: d = sdf_unimplemented_dual(); break;
+        default: return sdf_dual(100000.0, vec3(0.0), 0.0);
+    }
+    return sdf_dual_to_world(d, mat3(m), sdf_distance_scale(i));
+}
+
+SDFDual sdf_blend_union_dual(SDFDual a, SDFDual b){
+    return a.d < b.d ? a : b;
+}
+
+SDFDual sdf_blend_difference_dual(SDFDual a, SDFDual b){
+    b.d = -b.d;
+    b.g = -b.g;
+    return a.d > b.d ? a : b;
+}
+
+SDFDual sdf_blend_intersect_dual(SDFDual a, SDFDual b){
+    return a.d > b.d ? a : b;
+}
+
+// d = min(a, b) - e^2 / 4k with e = max(k - |a - b|, 0), whose gradient is
+// the nearer gradient moved e / 2k of the way towards the other
+SDFDual sdf_blend_smooth_union_dual(SDFDual a, SDFDual b, float k){
+    const float e = max(k - abs(a.d - b.d), 0.0);
+    const float h = e * 0.5 / k;
+    const float dis = min(a.d, b.d) - e * e * 0.25 / k;
+    return a.d < b.d ? sdf_dual(dis, mix(a.g, b.g, h), a.id) : sdf_dual(dis, mix(b.g, a.g, h), b.id);
+}
+
+SDFDual sdf_blend_smooth_difference_dual(SDFDual a, SDFDual b, float k){
+    a.d = -a.d;
+    a.g = -a.g;
+    SDFDual r = sdf_blend_smooth_union_dual(a, b, k);
+    r.d = -r.d;
+    r.g = -r.g;
+    return r;
+}
+
+// d = max(a, b) - e^2 / 4k, the gradient moves away from the other input
+SDFDual sdf_blend_smooth_intersect_dual(SDFDual a, SDFDual b, float k){
+    const float e = max(k - abs(a.d - b.d), 0.0);
+    const float h = e * 0.5 / k;
+    const float dis = max(a.d, b.d) - e * e * 0.25 / k;
+    return a.d > b.d ? sdf_dual(dis, mix(a.g, b.g, -h), a.id) : sdf_dual(dis, mix(b.g, a.g, -h), b.id);
+}
+
+SDFDual sdf_blend_dual(int i, SDFDual a, SDFDual b){
+    switch(sdf_blend_type(i)){
+        case SDF_BLEND_UNION: return sdf_blend_union_dual(a, b);
+        case SDF_BLEND_DIFF: return sdf_blend_difference_dual(a, b);
+        case SDF_BLEND_INT: return sdf_blend_intersect_dual(a, b);
+        case SDF_BLEND_SMTH_UNION: return sdf_blend_smooth_union_dual(a, b, sdf_blend_smoothness(i));
+        case SDF_BLEND_SMTH_DIFF: return sdf_blend_smooth_difference_dual(a, b, sdf_blend_smoothness(i));
+        case SDF_BLEND_SMTH_INT: return sdf_blend_smooth_intersect_dual(a, b, sdf_blend_smoothness(i));
+    }
+    return sdf_blend_union_dual(a, b);
+}
+
+SDFDual sdf_map_linear_dual(vec3 ray, int count){
+    SDFDual sam = sdf_dual(100000.0, vec3(0.0), -1.0);
+    for(int i = 0; i < count; ++i){
+        sam = sdf_blend_dual(i, sam, sdf_distance_dual(i, ray));
+    }
+    return sam;
+}
+
+// Distance and gradient of the first count edits. Culled edits are at least
+// their blend radius from ray, where they leave both untouched, so unlike
+// sdf_map_first the distance is only exact near the surface. Meant for
+// normals at hit points.
+SDFDual sdf_map_first_dual(vec3 ray, int count){
+    if(num_bvh_nodes == 0 || num_sdf_unbounded > BVH_MAX_CANDIDATES)
+        return sdf_map_linear_dual(ray, count);
+
+    int candidates[BVH_MAX_CANDIDATES];
+    const int num_candidates = bvh_gather(ray, count, candidates);
+    if(num_candidates < 0)
+        return sdf_map_linear_dual(ray, count);
+
+    SDFDual sam = sdf_dual(100000.0, vec3(0.0), -1.0);
+    for(int i = 0; i < num_candidates; ++i){
+        const int id = candidates[i];
+        sam = sdf_blend_dual(id, sam, sdf_distance_dual(id, ray));
+    }
+    return sam;
+}
+
+vec2 sdf_map(vec3 ray){
+    return sdf_map_first(ray, num_sdfs);
+}
+
+vec3 sdf_map_normal(vec3 point){
+    return normalize(sdf_map_first_dual(point, num_sdfs).g);
+}
+
+// six full evaluations, kept for comparison with sdf_map_normal
+vec3 sdf_map_normal_central(vec3 point){
+    vec3 e = vec3(0.0001, 0.0, 0.0);
+    return normalize(vec3(
+        sdf_map(point + e.xyz).x - sdf_map(point - e.xyz).x,
+        sdf_map(point + e.zxy).x - sdf_map(point - e.zxy).x,
+        sdf_map(point + e.zyx).x - sdf_map(point - e.zyx).x
+    ));
+}
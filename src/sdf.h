@@ -0,0 +1,138 @@
+#ifndef SDF_H
+#define SDF_H
+
+#include "glm/glm.hpp"
+#include "array.h"
+#include "aabb.h"
+#include "SSBO.h"
+#include "bvh.h"
+
+#define SDF_SPHERE 0
+#define SDF_BOX 1
+#define SDF_PLANE 2
+#define SDF_CONE 3
+#define SDF_PYRAMID 4
+#define SDF_TORUS 5
+#define SDF_CYLINDER 6
+#define SDF_CAPSULE 7
+#define SDF_DISK 8
+#define SDF_TYPE_COUNT 9
+
+#define SDF_BLEND_UNION 0
+#define SDF_BLEND_DIFF 1
+#define SDF_BLEND_INT 2
+#define SDF_BLEND_SMTH_UNION 3
+#define SDF_BLEND_SMTH_DIFF 4
+#define SDF_BLEND_SMTH_INT 5
+#define SDF_BLEND_COUNT 6
+
+#define MATERIAL_COUNT 4
+
+class ComputeShader;
+
+struct edit_params
+{
+    glm::vec3 t, r, s;
+    int dis_type, blend_type, mat_id;
+    float smoothness;
+    float uv_scale;
+    edit_params()
+    {
+        dis_type = 0;
+        blend_type = 0;
+        mat_id = 0;
+        smoothness = 0.5f;
+        uv_scale = 1.0f;
+        s = glm::vec3(1.0f);
+    }
+};
+
+class SDF
+{
+    glm::mat4 inv_xform;
+    glm::vec4 parameters; // [dis_type, blend_type, smoothness, material_id]
+    glm::vec4 extra_params; // [object_id, uv_scale, distance_scale]
+public:
+    SDF(){}
+    SDF(const edit_params& params);
+    inline int distance_type()const{ return int(parameters.x); }
+    inline int blend_type()const{ return int(parameters.y); }
+    inline float smoothness()const{ return parameters.z; }
+    inline int material_id()const{ return int(parameters.w); }
+    inline const glm::mat4& inverse_transform()const{ return inv_xform; }
+    inline float uv_scale()const{ return extra_params.y; }
+    // converts unit space distances back to world units
+    inline float distance_scale()const{ return extra_params.z; }
+    // radius over which the blend reaches past the primitive's surface
+    float blend_radius()const;
+    // false when the edit can change the field arbitrarily far from its primitive
+    bool bounded()const;
+    // true for union blends, which only ever add material
+    bool additive()const;
+    // world space box around the primitive's surface, excluding blend_radius
+    AABB bounds()const;
+    // box outside of which a bounded edit leaves the field unchanged
+    AABB influence()const;
+    // outside influence() a bounded edit pulls the field no lower than
+    // bound_slope() times the distance to it plus bound_offset(); the slope
+    // is below one for boxes and unevenly scaled edits
+    float bound_slope()const;
+    float bound_offset()const;
+    // true when both change the field and its materials alike, object ids aside
+    bool same_edit(const SDF& o)const;
+};
+
+// world space region of the field changed by a set of edits
+struct SDF_Change
+{
+    AABB region;
+    // the smallest bound_slope and bound_offset of the edits in region
+    float slope, offset;
+    bool everywhere;
+    SDF_Change() : slope(1.0f), offset(0.0f), everywhere(false){}
+    inline bool empty()const{ return !everywhere && region.empty(); }
+    void grow(const SDF& sdf);
+};
+
+class SDF_Edits
+{
+    Vector<SDF> sdfs;
+    SSBO ssbo;
+    SDF_BVH bvh;
+    SDF_Change committed;
+    // region changed since the last upload and by the edits it sent,
+    // brush included
+    SDF_Change pending, uploaded;
+    // first edit each region of the ssbo is missing
+    int dirty[SSBO_FRAMES];
+    unsigned changes, commits;
+    bool rebuild;
+    void mark(int first);
+public:
+    SDF_Edits();
+    // only needed for the gpu, the cpu tracer reads the edits directly
+    void init(int binding, int bvh_binding, int unbounded_binding);
+    void add_edit();
+    void update_brush(const edit_params& params);
+    void undo();
+    // sends the edits changed since the frame's region was last written,
+    // once per frame before any uniform call
+    void upload();
+    void uniform(ComputeShader& shader);
+    // box around every edit but the brush, empty if none are bounded
+    AABB committed_bounds()const;
+    // region changed by adding or undoing edits since the last clear,
+    // brush updates are not included as the brush is never cached
+    inline const SDF_Change& committed_change()const{ return committed; }
+    inline void clear_committed_change(){ committed = SDF_Change(); }
+    // region changed by the edits the last upload sent, brush included
+    inline const SDF_Change& uploaded_change()const{ return uploaded; }
+    // differs after every edit, brush update and undo
+    inline unsigned version()const{ return changes; }
+    // differs after every edit and undo, but not brush updates
+    inline unsigned committed_version()const{ return commits; }
+    inline int count()const{ return sdfs.count(); }
+    inline const SDF& operator[](int i)const{ return sdfs[i]; }
+};
+
+#endif
@@ -0,0 +1,204 @@
+#include "sdf_codegen.h"
+#include "sdf.h"
+#include "compute_shader.h"
+#include "myglheaders.h"
+#include "hash.h"
+#include <cstdio>
+#include <cstring>
+
+using namespace glm;
+
+// always has a decimal point, so no literal is ever taken for an int
+static std::string literal(float f){
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9g", f);
+    std::string s(buf);
+    if(s.find_first_of(".e") == std::string::npos)
+        s += ".0";
+    return s;
+}
+
+static const char* primitive_name(int type){
+    switch(type){
+        case SDF_SPHERE: return "sdf_sphere";
+        case SDF_BOX: return "sdf_box";
+        case SDF_PLANE: return "sdf_plane";
+        case SDF_CONE: return "sdf_cone";
+        case SDF_PYRAMID: return "sdf_pyramid";
+        case SDF_TORUS: return "sdf_torus";
+        case SDF_CYLINDER: return "sdf_cylinder";
+        case SDF_CAPSULE: return "sdf_capsule";
+        case SDF_DISK: return "sdf_disk";
+    }
+    return nullptr;
+}
+
+static std::string transform(const SDF& sdf){
+    // the last row of an affine inverse is always (0, 0, 0, 1)
+    const mat4& m = sdf.inverse_transform();
+    std::string s = "mat4x3(";
+    for(int c = 0; c < 4; ++c){
+        for(int r = 0; r < 3; ++r){
+            s += literal(m[c][r]);
+            if(c != 3 || r != 2)
+                s += ", ";
+        }
+    }
+    return s + ")";
+}
+
+static std::string blend(const SDF& sdf, const char* suffix){
+    std::string name;
+    std::string k;
+    switch(sdf.blend_type()){
+        default:
+        case SDF_BLEND_UNION: name = "sdf_blend_union"; break;
+        case SDF_BLEND_DIFF: name = "sdf_blend_difference"; break;
+        case SDF_BLEND_INT: name = "sdf_blend_intersect"; break;
+        case SDF_BLEND_SMTH_UNION: name = "sdf_blend_smooth_union"; k = literal(sdf.smoothness()); break;
+        case SDF_BLEND_SMTH_DIFF: name = "sdf_blend_smooth_difference"; k = literal(sdf.smoothness()); break;
+        case SDF_BLEND_SMTH_INT: name = "sdf_blend_smooth_intersect"; k = literal(sdf.smoothness()); break;
+    }
+    return "    sam = " + name + suffix + "(sam, d" + (k.empty() ? "" : ", " + k) + ");\n";
+}
+
+// sdf_map_committed, or sdf_map_committed_dual carrying gradients
+static void fold(std::string& src, const SDF* sdfs, int count, bool dual){
+    if(dual){
+        src += "SDFDual sdf_map_committed_dual(vec3 p){\n";
+        src += "    const vec4 hp = vec4(p, 1.0);\n";
+        src += "    SDFDual sam = sdf_dual(100000.0, vec3(0.0), -1.0);\n";
+        src += "    SDFDual d;\n";
+        src += "    mat4x3 m;\n";
+    }
+    else{
+        src += "vec2 sdf_map_committed(vec3 p){\n";
+        src += "    const vec4 hp = vec4(p, 1.0);\n";
+        src += "    vec2 sam = vec2(100000.0, -1.0);\n";
+        src += "    vec2 d;\n";
+    }
+    for(int i = 0; i < count; ++i){
+        const SDF& sdf = sdfs[i];
+        const std::string id = std::to_string(i);
+        const std::string scale = literal(sdf.distance_scale());
+        const char* prim = primitive_name(sdf.distance_type());
+        if(!prim){
+            src += dual ? "    d = sdf_dual(100000.0, vec3(0.0), 0.0);\n" : "    d = vec2(100000.0, 0.0);\n";
+        }
+        else if(dual){
+            switch(sdf.distance_type()){
+                case SDF_SPHERE:
+                case SDF_BOX:
+                case SDF_PLANE:
+                    src += "    m = " + transform(sdf) + ";\n";
+                    src += "    d = sdf_dual_to_world(" + std::string(prim) + "_dual(" + id + ", m * hp), mat3(m), " + scale + ");\n";
+                    break;
+                default:
+                    src += "    d = sdf_unimplemented_dual();\n";
+                    break;
+            }
+        }
+        else{
+            src += "    d = " + std::string(prim) + "(" + id + ", " + transform(sdf) + " * hp);\n";
+            src += "    d.x *= " + scale + ";\n";
+        }
+        src += blend(sdf, dual ? "_dual" : "");
+    }
+    src += "    return sam;\n";
+    src += "}\n";
+}
+
+std::string sdf_committed_source(const SDF* sdfs, int count){
+    std::string src;
+    src.reserve(1024 + count * 720);
+    src += "// generated by sdf_committed_source for " + std::to_string(count) + " edits\n\n";
+    fold(src, sdfs, count, false);
+    src += "\n";
+    fold(src, sdfs, count, true);
+    return src;
+}
+
+void sdf_committed_data(const SDF* sdfs, int count, Vector<float>& data){
+    data.clear();
+    if(data.capacity() < count * 21)
+        data.reserve(count * 21);
+    for(int i = 0; i < count; ++i){
+        const SDF& sdf = sdfs[i];
+        const mat4& m = sdf.inverse_transform();
+        for(int c = 0; c < 4; ++c){
+            for(int r = 0; r < 4; ++r){
+                data.grow() = m[c][r];
+            }
+        }
+        data.grow() = float(sdf.distance_type());
+        data.grow() = float(sdf.blend_type());
+        data.grow() = sdf.smoothness();
+        data.grow() = sdf.distance_scale();
+        data.grow() = float(i);
+    }
+}
+
+SDF_Programs::SDF_Programs(const std::string& file)
+    : filename(file), generic(file), frame(0), enabled(false){
+    // without parallel compiles every commit would stall on the driver
+    if(GLEW_ARB_parallel_shader_compile){
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        enabled = true;
+    }
+}
+
+SDF_Programs::~SDF_Programs(){
+    for(auto& v : variants){
+        delete v.second.shader;
+    }
+}
+
+SDF_Programs::Variant& SDF_Programs::variant(const SDF_Edits& edits, bool async){
+    const int count = edits.count() - 1;
+    sdf_committed_data(&edits[0], count, data);
+    const unsigned key = fnv(data.begin(), data.bytes());
+    auto iter = variants.find(key);
+    if(iter != variants.end() && iter->second.data.count() == data.count()
+        && memcmp(iter->second.data.begin(), data.begin(), data.bytes()) == 0){
+        iter->second.last_used = frame;
+        return iter->second;
+    }
+    // a colliding edit list takes the slot over
+    if(iter != variants.end()){
+        delete iter->second.shader;
+        variants.erase(iter);
+    }
+
+    if(variants.size() >= SDF_PROGRAM_CACHE_SIZE){
+        auto oldest = variants.begin();
+        for(auto i = variants.begin(); i != variants.end(); ++i){
+            if(i->second.last_used < oldest->second.last_used)
+                oldest = i;
+        }
+        delete oldest->second.shader;
+        variants.erase(oldest);
+    }
+
+    Variant& v = variants[key];
+    v.shader = new ComputeShader(filename, "sdf_committed.glsl", sdf_committed_source(&edits[0], count), async);
+    v.data = data;
+    v.last_used = frame;
+    return v;
+}
+
+ComputeShader& SDF_Programs::select(const SDF_Edits& edits){
+    ++frame;
+    const int count = edits.count() - 1;
+    if(!enabled || count < 1 || count > SDF_CODEGEN_MAX_EDITS)
+        return generic;
+    Variant& v = variant(edits, true);
+    return v.shader->ready() ? *v.shader : generic;
+}
+
+ComputeShader& SDF_Programs::specialized(const SDF_Edits& edits){
+    ++frame;
+    if(edits.count() < 2)
+        return generic;
+    Variant& v = variant(edits, false);
+    return v.shader->ready() ? *v.shader : generic;
+}
@@ -0,0 +1,55 @@
+#ifndef SDF_CODEGEN_H
+#define SDF_CODEGEN_H
+
+#include <string>
+#include <unordered_map>
+#include "compute_shader.h"
+#include "array.h"
+
+class SDF;
+class SDF_Edits;
+
+// the generated fold evaluates every edit with no bvh culling, which the
+// interpreter's gather bounds to BVH_MAX_CANDIDATES, so longer edit lists
+// stay on the interpreter
+#define SDF_CODEGEN_MAX_EDITS 64
+#define SDF_PROGRAM_CACHE_SIZE 8
+
+// sdf_committed.glsl with the first count edits folded into straight-line code
+std::string sdf_committed_source(const SDF* sdfs, int count);
+// everything sdf_committed_source reads, which tells variants apart
+void sdf_committed_data(const SDF* sdfs, int count, Vector<float>& data);
+
+/*
+    Variants of one compute shader with sdf_committed.glsl generated for
+    the committed edits. Variants compile on the driver's threads and are
+    kept for the last few edit lists, so undo and redo find them ready;
+    until then the generic interpreter is used.
+*/
+class SDF_Programs{
+    struct Variant{
+        ComputeShader* shader;
+        Vector<float> data; // the edits it was generated for
+        unsigned last_used;
+    };
+    std::string filename;
+    ComputeShader generic;
+    // keyed on a hash of the data, which lookups still compare
+    std::unordered_map<unsigned, Variant> variants;
+    Vector<float> data;
+    unsigned frame;
+    bool enabled;
+    Variant& variant(const SDF_Edits& edits, bool async);
+public:
+    SDF_Programs(const std::string& filename);
+    ~SDF_Programs();
+    inline void toggle(){ enabled = !enabled; }
+    inline bool on()const{ return enabled; }
+    // the program to use for the current edits
+    ComputeShader& select(const SDF_Edits& edits);
+    // blocks until the specialized program for the current edits is linked
+    ComputeShader& specialized(const SDF_Edits& edits);
+    inline ComputeShader& interpreter(){ return generic; }
+};
+
+#endif
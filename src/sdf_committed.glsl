@@ -0,0 +1,11 @@
+// Every edit but the brush. SDF_Codegen replaces this file with
+// straight-line code for the current edit list; this generic version
+// interprets the edit buffer until that program has linked.
+
+vec2 sdf_map_committed(vec3 p){
+    return sdf_map_first(p, num_sdfs - 1);
+}
+
+SDFDual sdf_map_committed_dual(vec3 p){
+    return sdf_map_first_dual(p, num_sdfs - 1);
+}
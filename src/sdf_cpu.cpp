@@ -0,0 +1,166 @@
+#include "sdf_cpu.h"
+#include "sdf.h"
+
+using namespace glm;
+
+static SDFDual sphere(int id, const vec3& p)
+{
+    const float l = length(p);
+    return SDFDual(l - 1.0f, p / glm::max(l, 0.000001f), id);
+}
+
+static SDFDual box(int id, const vec3& p)
+{
+    const vec3 d = abs(p) - vec3(1.0f);
+    vec3 g(0.0f);
+    if(d.x >= d.y && d.x >= d.z)
+        g.x = sign(p.x);
+    else if(d.y >= d.z)
+        g.y = sign(p.y);
+    else
+        g.z = sign(p.z);
+    return SDFDual(glm::max(glm::max(d.x, d.y), d.z), g, id);
+}
+
+SDFDual sdf_distance_dual(const SDF& sdf, int id, const vec3& point)
+{
+    const mat4& m = sdf.inverse_transform();
+    const vec4 x = m * vec4(point, 1.0f);
+    const vec3 p = vec3(x) / x.w;
+
+    SDFDual d;
+    switch(sdf.distance_type()){
+        case SDF_SPHERE: d = sphere(id, p); break;
+        case SDF_BOX: d = box(id, p); break;
+        case SDF_PLANE: d = SDFDual(p.y, vec3(0.0f, 1.0f, 0.0f), id); break;
+        case SDF_CONE:
+        case SDF_PYRAMID:
+        case SDF_TORUS:
+        case SDF_CYLINDER:
+        case SDF_CAPSULE:
+        case SDF_DISK: return SDFDual(0.0f, vec3(0.0f), 0);
+        default: return SDFDual(100000.0f, vec3(0.0f), 0);
+    }
+    const float scale = sdf.distance_scale();
+    d.d *= scale;
+    d.g = transpose(mat3(m)) * d.g * scale;
+    return d;
+}
+
+static SDFDual negate(SDFDual a)
+{
+    a.d = -a.d;
+    a.g = -a.g;
+    return a;
+}
+
+static SDFDual smooth_union(const SDFDual& a, const SDFDual& b, float k)
+{
+    const float e = glm::max(k - fabsf(a.d - b.d), 0.0f);
+    const float h = e * 0.5f / k;
+    const float d = glm::min(a.d, b.d) - e * e * 0.25f / k;
+    return a.d < b.d ? SDFDual(d, mix(a.g, b.g, h), a.id) : SDFDual(d, mix(b.g, a.g, h), b.id);
+}
+
+SDFDual sdf_blend_dual(const SDF& sdf, const SDFDual& a, const SDFDual& b)
+{
+    const float k = sdf.smoothness();
+    switch(sdf.blend_type()){
+        case SDF_BLEND_DIFF:
+        {
+            const SDFDual nb = negate(b);
+            return a.d > nb.d ? a : nb;
+        }
+        case SDF_BLEND_INT:
+            return a.d > b.d ? a : b;
+        case SDF_BLEND_SMTH_UNION:
+            return smooth_union(a, b, k);
+        case SDF_BLEND_SMTH_DIFF:
+            return negate(smooth_union(negate(a), b, k));
+        case SDF_BLEND_SMTH_INT:
+        {
+            const float e = glm::max(k - fabsf(a.d - b.d), 0.0f);
+            const float h = e * 0.5f / k;
+            const float d = glm::max(a.d, b.d) - e * e * 0.25f / k;
+            return a.d > b.d ? SDFDual(d, mix(a.g, b.g, -h), a.id) : SDFDual(d, mix(b.g, a.g, -h), b.id);
+        }
+    }
+    return a.d < b.d ? a : b;
+}
+
+SDFDual sdf_map_dual(const SDF_Edits& edits, const vec3& p)
+{
+    SDFDual sam;
+    for(int i = 0; i < edits.count(); ++i){
+        sam = sdf_blend_dual(edits[i], sam, sdf_distance_dual(edits[i], i, p));
+    }
+    return sam;
+}
+
+// a ? b : c per lane for both halves of a distance and id pair
+static inline void pick(vfloat mask, vfloat& d, vfloat& id, vfloat bd, vfloat bid, vfloat cd, vfloat cid)
+{
+    d = vselect(mask, bd, cd);
+    id = vselect(mask, bid, cid);
+}
+
+static void smooth_union_packet(vfloat& d, vfloat& id, vfloat bd, vfloat bid, float k)
+{
+    const vfloat e = vmax(vfloat(k) - vabs(d - bd), 0.0f);
+    const vfloat dis = vmin(d, bd) - e * e * (0.25f / k);
+    id = vselect(d < bd, id, bid);
+    d = dis;
+}
+
+void sdf_map_packet(const SDF_Edits& edits, const vvec3& p, vfloat& d, vfloat& id)
+{
+    d = 100000.0f;
+    id = -1.0f;
+    for(int i = 0; i < edits.count(); ++i){
+        const SDF& sdf = edits[i];
+        const mat4& m = sdf.inverse_transform();
+        vvec3 q;
+        q.x = p.x * m[0][0] + p.y * m[1][0] + p.z * m[2][0] + m[3][0];
+        q.y = p.x * m[0][1] + p.y * m[1][1] + p.z * m[2][1] + m[3][1];
+        q.z = p.x * m[0][2] + p.y * m[1][2] + p.z * m[2][2] + m[3][2];
+
+        vfloat bd;
+        vfloat bid = float(i);
+        switch(sdf.distance_type()){
+            case SDF_SPHERE: bd = vlength(q) - 1.0f; break;
+            case SDF_BOX: bd = vmax(vmax(vabs(q.x), vabs(q.y)), vabs(q.z)) - 1.0f; break;
+            case SDF_PLANE: bd = q.y; break;
+            case SDF_CONE:
+            case SDF_PYRAMID:
+            case SDF_TORUS:
+            case SDF_CYLINDER:
+            case SDF_CAPSULE:
+            case SDF_DISK: bd = 0.0f; bid = 0.0f; break;
+            default: bd = 100000.0f; bid = 0.0f; break;
+        }
+        if(sdf.distance_type() < SDF_TYPE_COUNT)
+            bd = bd * sdf.distance_scale();
+
+        const float k = sdf.smoothness();
+        switch(sdf.blend_type()){
+            default:
+            case SDF_BLEND_UNION: pick(d < bd, d, id, d, id, bd, bid); break;
+            case SDF_BLEND_DIFF: bd = -bd; pick(d > bd, d, id, d, id, bd, bid); break;
+            case SDF_BLEND_INT: pick(d > bd, d, id, d, id, bd, bid); break;
+            case SDF_BLEND_SMTH_UNION: smooth_union_packet(d, id, bd, bid, k); break;
+            case SDF_BLEND_SMTH_DIFF:
+                d = -d;
+                smooth_union_packet(d, id, bd, bid, k);
+                d = -d;
+                break;
+            case SDF_BLEND_SMTH_INT:
+            {
+                const vfloat e = vmax(vfloat(k) - vabs(d - bd), 0.0f);
+                const vfloat dis = vmax(d, bd) - e * e * (0.25f / k);
+                id = vselect(d > bd, id, bid);
+                d = dis;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef SDF_CPU_H
+#define SDF_CPU_H
+
+#include "glm/glm.hpp"
+#include "simd.h"
+
+class SDF;
+class SDF_Edits;
+
+// distance, world space gradient and edit id, as SDFDual in sdf.glsl
+struct SDFDual
+{
+    float d;
+    glm::vec3 g;
+    int id;
+    SDFDual() : d(100000.0f), g(0.0f), id(-1){}
+    SDFDual(float dis, const glm::vec3& grad, int i) : d(dis), g(grad), id(i){}
+};
+
+/*
+    CPU mirror of the linear fold in sdf.glsl, without the bvh. Kept in step
+    with the shader so results can be checked against it.
+*/
+SDFDual sdf_distance_dual(const SDF& sdf, int id, const glm::vec3& p);
+SDFDual sdf_blend_dual(const SDF& sdf, const SDFDual& a, const SDFDual& b);
+SDFDual sdf_map_dual(const SDF_Edits& edits, const glm::vec3& p);
+// distance and edit id at a packet of points
+void sdf_map_packet(const SDF_Edits& edits, const vvec3& p, vfloat& d, vfloat& id);
+
+#endif
@@ -0,0 +1,118 @@
+#include "sequence.h"
+#include "array.h"
+#include <cmath>
+
+#define NOISE_PIXELS (SEQUENCE_NOISE_SIZE * SEQUENCE_NOISE_SIZE)
+// width of the gaussian void and cluster measures crowding with
+#define NOISE_SIGMA 1.5f
+
+const char* SampleSequence::mode_name(int mode){
+    switch(mode){
+        case SEQUENCE_SOBOL: return "sobol";
+        case SEQUENCE_BLUE_NOISE: return "blue noise";
+    }
+    return "hash";
+}
+
+// direction numbers of the first two Sobol dimensions, the van der Corput
+// sequence and the primitive polynomial x + 1
+static void sobol_directions(unsigned* v){
+    for(unsigned k = 0; k < 32; ++k)
+        v[k] = 1u << (31 - k);
+    unsigned* w = v + 32;
+    w[0] = 1u << 31;
+    for(unsigned k = 1; k < 32; ++k)
+        w[k] = w[k - 1] ^ (w[k - 1] >> 1);
+}
+
+// Ulichney's void and cluster on a torus: pixels are ranked by adding
+// points where the pattern is emptiest and removing them where it is most
+// crowded, measured as the sum of a gaussian around every point
+struct VoidCluster{
+    float kernel[NOISE_PIXELS];
+    float energy[NOISE_PIXELS];
+    bool on[NOISE_PIXELS];
+    VoidCluster(){
+        const int n = SEQUENCE_NOISE_SIZE;
+        for(int y = 0; y < n; ++y){
+            for(int x = 0; x < n; ++x){
+                const float dx = float(x < n - x ? x : n - x);
+                const float dy = float(y < n - y ? y : n - y);
+                kernel[y * n + x] = expf(-(dx * dx + dy * dy) / (2.0f * NOISE_SIGMA * NOISE_SIGMA));
+                energy[y * n + x] = 0.0f;
+                on[y * n + x] = false;
+            }
+        }
+    }
+    void set(int p, bool value){
+        const int n = SEQUENCE_NOISE_SIZE;
+        const float sign = value ? 1.0f : -1.0f;
+        on[p] = value;
+        for(int q = 0; q < NOISE_PIXELS; ++q){
+            const int dx = ((q % n) - (p % n)) & (n - 1);
+            const int dy = ((q / n) - (p / n)) & (n - 1);
+            energy[q] += sign * kernel[dy * n + dx];
+        }
+    }
+    // the most crowded point, or the emptiest pixel without one
+    int find(bool cluster)const{
+        int best = -1;
+        for(int p = 0; p < NOISE_PIXELS; ++p){
+            if(on[p] != cluster)
+                continue;
+            if(best < 0 || (cluster ? energy[p] > energy[best] : energy[p] < energy[best]))
+                best = p;
+        }
+        return best;
+    }
+};
+
+static void blue_noise(unsigned* rank){
+    VoidCluster* vc = new VoidCluster;
+    // a tenth of the pixels at random, then moved from clusters to voids
+    // until the pattern is even
+    unsigned state = 1;
+    int ones = 0;
+    while(ones < NOISE_PIXELS / 10){
+        state = state * 1664525u + 1013904223u;
+        const int p = int(state >> 8) % NOISE_PIXELS;
+        if(!vc->on[p]){
+            vc->set(p, true);
+            ++ones;
+        }
+    }
+    for(;;){
+        const int cluster = vc->find(true);
+        vc->set(cluster, false);
+        const int empty = vc->find(false);
+        vc->set(empty, true);
+        if(empty == cluster)
+            break;
+    }
+    VoidCluster* prototype = new VoidCluster(*vc);
+
+    for(int r = ones - 1; r >= 0; --r){
+        const int p = vc->find(true);
+        vc->set(p, false);
+        rank[p] = unsigned(r);
+    }
+    for(int r = ones; r < NOISE_PIXELS; ++r){
+        const int p = prototype->find(false);
+        prototype->set(p, true);
+        rank[p] = unsigned(r);
+    }
+    delete vc;
+    delete prototype;
+}
+
+void SampleSequence::init(unsigned binding){
+    Vector<unsigned> data;
+    data.resize(SEQUENCE_SOBOL_DIMS * 32 + NOISE_PIXELS);
+    sobol_directions(data.begin());
+    blue_noise(data.begin() + SEQUENCE_SOBOL_DIMS * 32);
+    tables.init(data.begin(), data.bytes(), binding);
+}
+
+void SampleSequence::uniform(ComputeShader& prog)const{
+    prog.setUniformInt("sample_sequence", mode);
+}
@@ -0,0 +1,78 @@
+// Low discrepancy sample points, see sequence.h. Dimensions come in pairs:
+// sequence_sample(pair) is the pair of the sample sequence_begin started.
+
+#define SEQUENCE_HASH 0
+#define SEQUENCE_SOBOL 1
+#define SEQUENCE_BLUE_NOISE 2
+// must match sequence.h
+#define SEQUENCE_SOBOL_DIMS 2
+#define SEQUENCE_NOISE_SIZE 64
+
+uniform int sample_sequence;
+layout(std430, binding = 15) readonly buffer SEQUENCE_BUF
+{
+    uint sobol_directions[SEQUENCE_SOBOL_DIMS * 32];
+    uint noise_ranks[SEQUENCE_NOISE_SIZE * SEQUENCE_NOISE_SIZE];
+};
+
+ivec2 sequence_pix;
+uint sequence_index;
+uint sequence_seed;
+
+uint sequence_hash(uint x){
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// Burley's hash based Owen scramble, a random nested permutation of the bits
+uint owen_scramble(uint x, uint seed){
+    x = bitfieldReverse(x);
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return bitfieldReverse(x);
+}
+
+uint sobol(uint index, uint dim){
+    uint x = 0u;
+    for(uint k = 0u; index != 0u; ++k, index >>= 1){
+        if((index & 1u) != 0u)
+            x ^= sobol_directions[dim * 32u + k];
+    }
+    return x;
+}
+
+// index counts the samples pix took before, salt changes every scramble
+void sequence_begin(ivec2 pix, uint index, uint salt){
+    sequence_pix = pix;
+    sequence_index = index;
+    sequence_seed = sequence_hash(uint(pix.x) | (uint(pix.y) << 16)) ^ salt;
+}
+
+vec2 sequence_sample(uint pair){
+    if(sample_sequence == SEQUENCE_SOBOL){
+        // shuffled and scrambled apart per pair, so pairs are not correlated
+        const uint seed = sequence_hash(sequence_seed ^ sequence_hash(pair));
+        const uint i = owen_scramble(sequence_index, seed);
+        const uvec2 x = uvec2(
+            owen_scramble(sobol(i, 0u), sequence_hash(seed ^ 0x5bd1e995u)),
+            owen_scramble(sobol(i, 1u), sequence_hash(seed ^ 0x27d4eb2du)));
+        return vec2(x >> 8u) * (1.0 / 16777216.0);
+    }
+    // the mask at an offset per pair and dimension, shifted along the
+    // R2 sequence each sample
+    const uint h = sequence_hash(pair);
+    const ivec2 a = (sequence_pix + ivec2(h & 0xffu, (h >> 8) & 0xffu)) & (SEQUENCE_NOISE_SIZE - 1);
+    const ivec2 b = (sequence_pix + ivec2((h >> 16) & 0xffu, h >> 24)) & (SEQUENCE_NOISE_SIZE - 1);
+    const vec2 rank = vec2(
+        noise_ranks[a.y * SEQUENCE_NOISE_SIZE + a.x],
+        noise_ranks[b.y * SEQUENCE_NOISE_SIZE + b.x]);
+    const vec2 u = (rank + 0.5) / float(SEQUENCE_NOISE_SIZE * SEQUENCE_NOISE_SIZE);
+    return fract(u + float(sequence_index) * vec2(0.7548776662, 0.5698402910));
+}
@@ -0,0 +1,41 @@
+#ifndef SEQUENCE_H
+#define SEQUENCE_H
+
+#include "compute_shader.h"
+#include "SSBO.h"
+
+#define SEQUENCE_HASH 0
+#define SEQUENCE_SOBOL 1
+#define SEQUENCE_BLUE_NOISE 2
+#define SEQUENCE_COUNT 3
+
+// must match sequence.glsl
+#define SEQUENCE_SOBOL_DIMS 2
+#define SEQUENCE_NOISE_SIZE 64
+
+/*
+    Sample points of the path tracer, chosen by sample_sequence in
+    sequence.glsl. The hash is the white noise integer hash depth.glsl
+    always used. Sobol is an Owen scrambled 2D Sobol sequence indexed by
+    pixel, sample and pair of dimensions: each pair shuffles the sample
+    index and scrambles the points with its own hash of the pixel, so
+    pairs stay decorrelated. Blue noise reads a tiled void and cluster
+    mask at an offset per pair, rotated each sample along the R2 sequence.
+
+    Storage: the Sobol direction numbers and the blue noise ranks, both
+    built on the cpu at init, at one ssbo binding.
+*/
+class SampleSequence{
+    SSBO tables;
+    int mode;
+public:
+    SampleSequence() : mode(SEQUENCE_HASH){}
+    void init(unsigned binding);
+    inline void set_mode(int new_mode){ mode = new_mode % SEQUENCE_COUNT; }
+    inline int get_mode()const{ return mode; }
+    static const char* mode_name(int mode);
+    // program must be bound
+    void uniform(ComputeShader& prog)const;
+};
+
+#endif
@@ -0,0 +1,353 @@
+// materials, random numbers and the brdf of the path tracer, shared by
+// depth.glsl and the wavefront kernels. Needs CAM_BUF, scene.glsl and
+// accumulate.glsl.
+
+#include "sequence.glsl"
+#include "primary_cache.glsl"
+
+uniform sampler2D albedo0;
+uniform sampler2D albedo1;
+uniform sampler2D albedo2;
+uniform sampler2D albedo3;
+
+uniform sampler2D normal0;
+uniform sampler2D normal1;
+uniform sampler2D normal2;
+uniform sampler2D normal3;
+
+uniform sampler2D material0;
+uniform sampler2D material1;
+uniform sampler2D material2;
+uniform sampler2D material3;
+
+// w is emission
+vec4 sdf_albedo_texture(int i, vec2 uv){
+    int mat_id = sdf_material_id(i);
+    switch(mat_id){
+        default:
+        case 0: return texture(albedo0, uv);
+        case 1: return texture(albedo1, uv);
+        case 2: return texture(albedo2, uv);
+        case 3: return texture(albedo3, uv);
+    }
+    return vec4(0.0);
+}
+
+vec4 sdf_normal_texture(int i, vec2 uv){
+    int mat_id = sdf_material_id(i);
+    switch(mat_id){
+        default:
+        case 0: return texture(normal0, uv);
+        case 1: return texture(normal1, uv);
+        case 2: return texture(normal2, uv);
+        case 3: return texture(normal3, uv);
+    }
+    return vec4(0.0);
+}
+
+vec4 sdf_material_texture(int i, vec2 uv){
+    int mat_id = sdf_material_id(i);
+    switch(mat_id){
+        default:
+        case 0: return texture(material0, uv);
+        case 1: return texture(material1, uv);
+        case 2: return texture(material2, uv);
+        case 3: return texture(material3, uv);
+    }
+    return vec4(0.0);
+}
+
+vec3 toWorld(float x, float y, float z){
+    vec4 t = vec4(x, y, z, 1.0);
+    t = IVP * t;
+    return vec3(t/t.w);
+}
+
+float randUni(inout uint f){
+    f = (f ^ 61) ^ (f >> 16);
+    f *= 9;
+    f = f ^ (f >> 4);
+    f *= 0x27d4eb2d;
+    f = f ^ (f >> 15);
+    return fract(float(f) * 2.3283064e-10);
+}
+
+float rand( inout uint f) {
+   return randUni(f) * 2.0 - 1.0;
+}
+
+// starts pix's next sample of the low discrepancy sequences, numbered by
+// the samples its history holds
+void begin_sample(ivec2 pix){
+    if(sample_sequence == SEQUENCE_HASH)
+        return;
+    const uint index = history != 0 ? uint(imageLoad(prev_color, pix).w) : 0u;
+    // without history every frame is a first sample, scrambled anew
+    sequence_begin(pix, index, history != 0 ? 0u : floatBitsToUint(seed.z));
+}
+
+// two dimensions of the path's sample: pair 0 jitters the pixel and pair
+// 1 + i picks the direction of bounce i; the hash draws them from s
+vec2 sample2(inout uint s, uint pair){
+    if(sample_sequence == SEQUENCE_HASH)
+        return vec2(randUni(s), randUni(s));
+    return sequence_sample(pair);
+}
+
+// jittered ray through pix, seeding s for the rest of its path; the
+// primary cache fixes the jitter to the frame's point of the pixel
+vec3 primary_ray(ivec2 pix, ivec2 size, out uint s){
+    s = uint(seed.z + 10000.0 * dot(seed.xy, vec2(pix)));
+    begin_sample(pix);
+    vec2 aa = (sample2(s, 0u) * 2.0 - 1.0) * 0.5;
+    if(primary_cache != 0)
+        aa = primary_offset();
+    const vec2 uv = (vec2(pix + aa) / vec2(size))* 2.0 - 1.0;
+    return normalize(toWorld(uv.x, uv.y, 0.0) - EYE);
+}
+
+// tangent, bitangent and N, Duff et al.'s branchless basis
+mat3 basis(vec3 N){
+    const float sgn = N.z >= 0.0 ? 1.0 : -1.0;
+    const float a = -1.0 / (sgn + N.z);
+    const float b = N.x * N.y * a;
+    return mat3(
+        vec3(1.0 + sgn * N.x * N.x * a, sgn * b, -sgn * N.x),
+        vec3(b, sgn + N.y * N.y * a, -N.y),
+        N);
+}
+
+// uniform over the hemisphere around N
+vec3 uniHemi(vec3 N, inout uint s, uint pair){
+    if(sample_sequence != SEQUENCE_HASH){
+        const vec2 u = sequence_sample(pair);
+        const float r = sqrt(max(0.0, 1.0 - u.x * u.x));
+        const float phi = 6.2831853 * u.y;
+        return basis(N) * vec3(r * cos(phi), r * sin(phi), u.x);
+    }
+    vec3 dir;
+    float len;
+    int i = 0;
+    do {
+        dir = vec3(rand(s), rand(s), rand(s));
+        len = length(dir);
+    }
+    while(len > 1.0 && i < 5);
+    
+    if(dot(dir, N) < 0.0)
+        dir *= -1.0;
+    
+    return dir / len;
+}
+
+vec3 roughBlend(vec3 newdir, vec3 I, vec3 N, float roughness){
+    return normalize(
+        mix(
+            normalize(
+                reflect(I, N)), 
+            newdir, 
+            roughness
+            )
+        );
+}
+
+vec2 uv_from_ray(vec3 N, vec3 p){
+    vec3 d = abs(N);
+    float a = vmax(d);
+    if(a == d.x){
+        return vec2(p.z, p.y);
+    }
+    else if(a == d.y){
+        return vec2(p.x, p.z);
+    }
+    return vec2(p.x, p.y);
+}
+
+float DisGGX(vec3 N, vec3 H, float roughness)
+{
+    const float a = roughness * roughness;
+    const float a2 = a * a;
+    const float NdH = max(dot(N, H), 0.0);
+    const float NdH2 = NdH * NdH;
+
+    const float nom = a2;
+    const float denom_term = (NdH2 * (a2 - 1.0) + 1.0);
+    const float denom = 3.141592 * denom_term * denom_term;
+
+    return nom / denom;
+}
+
+float GeomSchlickGGX(float NdV, float roughness)
+{
+    const float r = (roughness + 1.0);
+    const float k = (r * r) / 8.0;
+
+    const float nom = NdV;
+    const float denom = NdV * (1.0 - k) + k;
+
+    return nom / denom;
+}
+
+float GeomSmith(vec3 N, vec3 V, vec3 L, float roughness)
+{
+    const float NdV = max(dot(N, V), 0.0);
+    const float NdL = max(dot(N, L), 0.0);
+    const float ggx2 = GeomSchlickGGX(NdV, roughness);
+    const float ggx1 = GeomSchlickGGX(NdL, roughness);
+
+    return ggx1 * ggx2;
+}
+
+vec3 fresnelSchlick(float cosTheta, vec3 F0)
+{
+    // pow is undefined below 0, where rounding can put cosines of 1
+    return F0 + (1.0 - F0) * pow(max(1.0 - cosTheta, 0.0), 5.0);
+}
+
+vec3 pbr_lighting(vec3 V, vec3 L, vec3 N, vec3 albedo, float metalness, float roughness)
+{
+    const float NdL = max(0.0, dot(N, L));
+    const vec3 F0 = mix(vec3(0.04), albedo, metalness);
+    const vec3 H = normalize(V + L);
+
+    const float NDF = DisGGX(N, H, roughness);
+    const float G = GeomSmith(N, V, L, roughness);
+    const vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+    const vec3 nom = NDF * G * F;
+    const float denom = 4.0 * max(dot(N, V), 0.0) * NdL + 0.001;
+    const vec3 specular = nom / denom;
+
+    const vec3 kS = F;
+    const vec3 kD = (vec3(1.0) - kS) * (1.0 - metalness);
+
+    return (kD * albedo / 3.141592 + specular) * NdL;
+}
+
+// With uniform_hemisphere set, paths continue in uniHemi directions
+// weighted by pbr_lighting alone. Otherwise sample_brdf picks the diffuse
+// lobe by its cosine or the specular lobe by GGX's distribution of visible
+// normals, and weighs by the pdf of both lobes together, the balance
+// heuristic of one-sample MIS. Weights keep the 1 / 2pi scale of the
+// uniform estimator the emission was tuned with.
+uniform int uniform_hemisphere;
+
+float luminance(vec3 c){
+    return dot(c, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// the GGX distribution over alpha, the square of roughness
+float ggx_D(float NdH, float alpha){
+    const float a2 = alpha * alpha;
+    const float d = NdH * NdH * (a2 - 1.0) + 1.0;
+    return a2 / (3.141592 * d * d);
+}
+
+float ggx_G1(float NdV, float alpha){
+    const float a2 = alpha * alpha;
+    return 2.0 * NdV / (NdV + sqrt(a2 + (1.0 - a2) * NdV * NdV));
+}
+
+float ggx_alpha(float roughness){
+    return max(roughness * roughness, 0.001);
+}
+
+// chance of taking the specular lobe, by the share of the reflection
+// Fresnel gives it, never so small that either lobe goes unsampled
+float specular_chance(float NdV, vec3 albedo, float metalness){
+    if(NdV <= 0.0)
+        return 0.0;
+    const vec3 F = fresnelSchlick(NdV, mix(vec3(0.04), albedo, metalness));
+    const float spec = luminance(F);
+    const float diff = luminance((vec3(1.0) - F) * (1.0 - metalness) * albedo);
+    return clamp(spec / max(spec + diff, 0.0001), 0.1, 0.9);
+}
+
+// Heitz's sampling of the visible normals of V, in the basis of the surface
+vec3 ggx_visible_normal(vec3 V, float alpha, vec2 u){
+    const vec3 Vh = normalize(vec3(alpha * V.x, alpha * V.y, V.z));
+    const float lensq = Vh.x * Vh.x + Vh.y * Vh.y;
+    const vec3 T1 = lensq > 0.0 ? vec3(-Vh.y, Vh.x, 0.0) * inversesqrt(lensq) : vec3(1.0, 0.0, 0.0);
+    const vec3 T2 = cross(Vh, T1);
+    const float r = sqrt(u.x);
+    const float phi = 6.2831853 * u.y;
+    const float t1 = r * cos(phi);
+    const float s = 0.5 * (1.0 + Vh.z);
+    const float t2 = mix(sqrt(max(0.0, 1.0 - t1 * t1)), r * sin(phi), s);
+    const vec3 Nh = t1 * T1 + t2 * T2 + sqrt(max(0.0, 1.0 - t1 * t1 - t2 * t2)) * Vh;
+    return normalize(vec3(alpha * Nh.x, alpha * Nh.y, max(0.0, Nh.z)));
+}
+
+// density of L among the directions sample_brdf picks
+float brdf_pdf(vec3 V, vec3 L, vec3 N, float chance, float alpha){
+    const float NdL = dot(N, L);
+    if(NdL <= 0.0)
+        return 0.0;
+    float pdf = (1.0 - chance) * NdL / 3.141592;
+    if(chance > 0.0){
+        const vec3 H = normalize(V + L);
+        const float NdV = dot(N, V);
+        pdf += chance * ggx_D(clamp(dot(N, H), 0.0, 1.0), alpha) * ggx_G1(NdV, alpha) / (4.0 * NdV);
+    }
+    return pdf;
+}
+
+// density of sample_brdf picking L
+float brdf_density(vec3 V, vec3 L, vec3 N, vec3 albedo, float metalness, float roughness){
+    if(uniform_hemisphere != 0)
+        return dot(N, L) > 0.0 ? 1.0 / 6.2831853 : 0.0;
+    return brdf_pdf(V, L, N, specular_chance(dot(N, V), albedo, metalness), ggx_alpha(roughness));
+}
+
+// next direction of a path leaving N towards V, its throughput in weight
+// and its density in pdf
+vec3 sample_brdf(vec3 V, vec3 N, vec3 albedo, float metalness, float roughness,
+    inout uint s, uint pair, out vec3 weight, out float pdf){
+    if(uniform_hemisphere != 0){
+        const vec3 L = uniHemi(N, s, pair);
+        weight = pbr_lighting(V, L, N, albedo, metalness, roughness);
+        pdf = 1.0 / 6.2831853;
+        return L;
+    }
+    const mat3 TBN = basis(N);
+    const float NdV = dot(N, V);
+    const float chance = specular_chance(NdV, albedo, metalness);
+    const float alpha = ggx_alpha(roughness);
+    vec2 u = sample2(s, pair);
+    vec3 L;
+    // the lobe is picked by the first dimension, stretched back over [0, 1)
+    if(u.x < chance){
+        u.x /= chance;
+        const vec3 H = TBN * ggx_visible_normal(V * TBN, alpha, u);
+        L = reflect(-V, H);
+    }
+    else{
+        u.x = (u.x - chance) / (1.0 - chance);
+        const float r = sqrt(u.x);
+        const float phi = 6.2831853 * u.y;
+        L = TBN * vec3(r * cos(phi), r * sin(phi), sqrt(max(0.0, 1.0 - u.x)));
+    }
+    pdf = brdf_pdf(V, L, N, chance, alpha);
+    weight = pdf > 0.0 ? pbr_lighting(V, L, N, albedo, metalness, roughness) / (6.2831853 * pdf) : vec3(0.0);
+    return L;
+}
+
+// Russian roulette once a path has taken limits.z bounces: it goes on with
+// a chance following its throughput, mask's brightest channel with the
+// 1 / 2pi of each bounce taken out, and survivors are weighed up by it
+float roulette_chance(vec3 mask, int bounces){
+    const float m = max(mask.r, max(mask.g, mask.b)) * pow(6.2831853, float(bounces));
+    // the floor bounds how far a survivor is weighed up
+    return m > 0.0 ? clamp(m, 0.05, 1.0) : 0.0;
+}
+
+// false when the path stops
+bool roulette(inout vec3 mask, int bounces, inout uint s){
+    if(limits.w == 0 || bounces < limits.z || bounces >= limits.x)
+        return true;
+    const float keep = roulette_chance(mask, bounces);
+    if(randUni(s) >= keep)
+        return false;
+    mask /= keep;
+    return true;
+}
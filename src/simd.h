@@ -0,0 +1,124 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+/*
+    Lanes of a cpu ray packet: 8 wide when built with AVX, 4 wide with SSE2
+    and a single scalar lane on anything else. Comparisons return masks of
+    all set or all clear lanes, which vselect() and the bitwise operators
+    consume.
+*/
+
+#if defined(__AVX__)
+
+#include <immintrin.h>
+
+#define SIMD_WIDTH 8
+
+struct vfloat{
+    __m256 v;
+    vfloat(){}
+    vfloat(__m256 x) : v(x){}
+    vfloat(float x) : v(_mm256_set1_ps(x)){}
+    static inline vfloat load(const float* p){ return _mm256_loadu_ps(p); }
+    inline void store(float* p)const{ _mm256_storeu_ps(p, v); }
+};
+
+inline vfloat operator+(vfloat a, vfloat b){ return _mm256_add_ps(a.v, b.v); }
+inline vfloat operator-(vfloat a, vfloat b){ return _mm256_sub_ps(a.v, b.v); }
+inline vfloat operator*(vfloat a, vfloat b){ return _mm256_mul_ps(a.v, b.v); }
+inline vfloat operator/(vfloat a, vfloat b){ return _mm256_div_ps(a.v, b.v); }
+inline vfloat operator&(vfloat a, vfloat b){ return _mm256_and_ps(a.v, b.v); }
+inline vfloat operator|(vfloat a, vfloat b){ return _mm256_or_ps(a.v, b.v); }
+inline vfloat andnot(vfloat a, vfloat b){ return _mm256_andnot_ps(a.v, b.v); }
+inline vfloat operator<(vfloat a, vfloat b){ return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline vfloat operator>(vfloat a, vfloat b){ return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline vfloat vmin(vfloat a, vfloat b){ return _mm256_min_ps(a.v, b.v); }
+inline vfloat vmax(vfloat a, vfloat b){ return _mm256_max_ps(a.v, b.v); }
+inline vfloat vsqrt(vfloat a){ return _mm256_sqrt_ps(a.v); }
+// mask ? a : b
+inline vfloat vselect(vfloat mask, vfloat a, vfloat b){ return _mm256_blendv_ps(b.v, a.v, mask.v); }
+inline int movemask(vfloat mask){ return _mm256_movemask_ps(mask.v); }
+
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+
+#define SIMD_WIDTH 4
+
+struct vfloat{
+    __m128 v;
+    vfloat(){}
+    vfloat(__m128 x) : v(x){}
+    vfloat(float x) : v(_mm_set1_ps(x)){}
+    static inline vfloat load(const float* p){ return _mm_loadu_ps(p); }
+    inline void store(float* p)const{ _mm_storeu_ps(p, v); }
+};
+
+inline vfloat operator+(vfloat a, vfloat b){ return _mm_add_ps(a.v, b.v); }
+inline vfloat operator-(vfloat a, vfloat b){ return _mm_sub_ps(a.v, b.v); }
+inline vfloat operator*(vfloat a, vfloat b){ return _mm_mul_ps(a.v, b.v); }
+inline vfloat operator/(vfloat a, vfloat b){ return _mm_div_ps(a.v, b.v); }
+inline vfloat operator&(vfloat a, vfloat b){ return _mm_and_ps(a.v, b.v); }
+inline vfloat operator|(vfloat a, vfloat b){ return _mm_or_ps(a.v, b.v); }
+inline vfloat andnot(vfloat a, vfloat b){ return _mm_andnot_ps(a.v, b.v); }
+inline vfloat operator<(vfloat a, vfloat b){ return _mm_cmplt_ps(a.v, b.v); }
+inline vfloat operator>(vfloat a, vfloat b){ return _mm_cmpgt_ps(a.v, b.v); }
+inline vfloat vmin(vfloat a, vfloat b){ return _mm_min_ps(a.v, b.v); }
+inline vfloat vmax(vfloat a, vfloat b){ return _mm_max_ps(a.v, b.v); }
+inline vfloat vsqrt(vfloat a){ return _mm_sqrt_ps(a.v); }
+// mask ? a : b, without SSE4.1's blendv
+inline vfloat vselect(vfloat mask, vfloat a, vfloat b){ return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)); }
+inline int movemask(vfloat mask){ return _mm_movemask_ps(mask.v); }
+
+#else
+
+#include <cmath>
+#include <cstring>
+
+#define SIMD_WIDTH 1
+
+struct vfloat{
+    float v;
+    vfloat(){}
+    vfloat(float x) : v(x){}
+    static inline vfloat load(const float* p){ return *p; }
+    inline void store(float* p)const{ *p = v; }
+};
+
+// masks keep their bits in the float, as in the vector registers
+inline unsigned vbits(vfloat a){ unsigned u; memcpy(&u, &a.v, sizeof(u)); return u; }
+inline vfloat vfrombits(unsigned u){ float f; memcpy(&f, &u, sizeof(f)); return f; }
+
+inline vfloat operator+(vfloat a, vfloat b){ return a.v + b.v; }
+inline vfloat operator-(vfloat a, vfloat b){ return a.v - b.v; }
+inline vfloat operator*(vfloat a, vfloat b){ return a.v * b.v; }
+inline vfloat operator/(vfloat a, vfloat b){ return a.v / b.v; }
+inline vfloat operator&(vfloat a, vfloat b){ return vfrombits(vbits(a) & vbits(b)); }
+inline vfloat operator|(vfloat a, vfloat b){ return vfrombits(vbits(a) | vbits(b)); }
+inline vfloat andnot(vfloat a, vfloat b){ return vfrombits(~vbits(a) & vbits(b)); }
+inline vfloat operator<(vfloat a, vfloat b){ return vfrombits(a.v < b.v ? ~0u : 0u); }
+inline vfloat operator>(vfloat a, vfloat b){ return vfrombits(a.v > b.v ? ~0u : 0u); }
+// the operand order of minps and maxps, which return b when either is nan
+inline vfloat vmin(vfloat a, vfloat b){ return a.v < b.v ? a : b; }
+inline vfloat vmax(vfloat a, vfloat b){ return a.v > b.v ? a : b; }
+inline vfloat vsqrt(vfloat a){ return std::sqrt(a.v); }
+// mask ? a : b
+inline vfloat vselect(vfloat mask, vfloat a, vfloat b){ return vbits(mask) ? a : b; }
+inline int movemask(vfloat mask){ return int(vbits(mask) >> 31); }
+
+#endif
+
+#define SIMD_ALL ((1 << SIMD_WIDTH) - 1)
+
+inline vfloat operator-(vfloat a){ return vfloat(0.0f) - a; }
+inline vfloat vabs(vfloat a){ return andnot(vfloat(-0.0f), a); }
+inline bool vany(vfloat mask){ return movemask(mask) != 0; }
+inline bool vall(vfloat mask){ return movemask(mask) == SIMD_ALL; }
+
+struct vvec3{
+    vfloat x, y, z;
+};
+
+inline vfloat vlength(const vvec3& a){ return vsqrt(a.x * a.x + a.y * a.y + a.z * a.z); }
+
+#endif
@@ -51,6 +51,11 @@ struct Texture{
             
         MYGLERRORMACRO   
     }
+    // reads the finest level back, p must hold width * height texels
+    void download(void* p){
+        glBindTexture(GL_TEXTURE_2D, handle);  MYGLERRORMACRO
+        glGetTexImage(GL_TEXTURE_2D, 0, Channels, ComponentType, p);  MYGLERRORMACRO
+    }
     void init(const image& img){
         init(img.width, img.height, true);
         upload(img.data);
@@ -85,6 +90,49 @@ struct Texture{
     }
 };
 
+template<typename T, s32 FullType, s32 Channels, s32 ComponentType>    
+struct Texture3{    
+    s32 width, height, depth;
+    u32 handle;
+    void init(s32 w, s32 h, s32 d, bool linear = false){
+        release();
+        width = w;
+        height = h;
+        depth = d;
+        const s32 filter = linear ? GL_LINEAR : GL_NEAREST;
+        glGenTextures(1, &handle);    MYGLERRORMACRO
+        glBindTexture(GL_TEXTURE_3D, handle);    MYGLERRORMACRO
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);    MYGLERRORMACRO    
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);    MYGLERRORMACRO    
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);    MYGLERRORMACRO    
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, filter);    MYGLERRORMACRO    
+        glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, filter);    MYGLERRORMACRO    
+        glTexImage3D(GL_TEXTURE_3D, 0, FullType, width, height, depth, 0, Channels, ComponentType, NULL);    MYGLERRORMACRO    
+    }
+    void release(){
+        if(!handle)
+            return;
+        glDeleteTextures(1, &handle);    MYGLERRORMACRO  
+        handle = 0;
+    }
+    Texture3() : width(0), height(0), depth(0), handle(0){
+    }
+    ~Texture3(){
+        release();   
+    }
+    void bind(s32 channel, const char* uname, ComputeShader& prog){    
+        glActiveTexture(GL_TEXTURE0 + channel);    
+        MYGLERRORMACRO    
+        glBindTexture(GL_TEXTURE_3D, handle);    
+        MYGLERRORMACRO
+        prog.setUniformInt(uname, channel);
+    }
+    void setCSBinding(int binding, int mode=GL_READ_ONLY){
+        glBindImageTexture(binding, handle, 0, GL_TRUE, 0, mode, FullType);
+        MYGLERRORMACRO 
+    }
+};
+
 typedef Texture<f32,       GL_R32F,    GL_RED,  GL_FLOAT> Texture1f;
 typedef Texture<glm::vec2, GL_RG32F,   GL_RG,   GL_FLOAT> Texture2f;
 typedef Texture<glm::vec4, GL_RGBA32F, GL_RGBA, GL_FLOAT> Texture4f;
@@ -96,5 +144,9 @@ typedef Texture<u8,     GL_R8,    GL_RED,  GL_UNSIGNED_BYTE> Texture1uc;
 typedef Texture<ucvec2, GL_RG8,   GL_RG,   GL_UNSIGNED_BYTE> Texture2uc;
 typedef Texture<ucvec4, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE> Texture4uc;
 
+typedef Texture3<f32,       GL_R32F,  GL_RED,         GL_FLOAT> Texture3D1f;
+typedef Texture3<glm::vec2, GL_RG32F, GL_RG,          GL_FLOAT> Texture3D2f;
+typedef Texture3<s32,       GL_R32I,  GL_RED_INTEGER, GL_INT>   Texture3D1i;
+
 #endif
 
@@ -0,0 +1,99 @@
+#include "tilequeue.h"
+#include "array.h"
+#include "myglheaders.h"
+#include <algorithm>
+
+struct TileQueueHeader{
+    unsigned next;
+    unsigned count;
+};
+
+// workgroups per streaming multiprocessor, enough to hide latency
+#define TILE_GROUPS_PER_SM 16
+// without a way to ask the device
+#define TILE_GROUPS_DEFAULT 512
+
+static unsigned morton(unsigned x, unsigned y){
+    unsigned key = 0;
+    for(unsigned b = 0; b < 16; ++b){
+        key |= ((x >> b) & 1u) << (2 * b);
+        key |= ((y >> b) & 1u) << (2 * b + 1);
+    }
+    return key;
+}
+
+// distance along the Hilbert curve filling an n by n grid, n a power of two
+static unsigned hilbert(unsigned n, unsigned x, unsigned y){
+    unsigned d = 0;
+    for(unsigned s = n / 2; s > 0; s /= 2){
+        const unsigned rx = (x & s) ? 1 : 0;
+        const unsigned ry = (y & s) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if(ry == 0){
+            if(rx == 1){
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+const char* TileQueue::order_name(int order){
+    switch(order){
+        case TILE_ORDER_MORTON: return "morton";
+        case TILE_ORDER_HILBERT: return "hilbert";
+    }
+    return "scanline";
+}
+
+void TileQueue::init(int width, int height, unsigned binding){
+    tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    GLint sms = 0;
+    if(GLEW_NV_shader_thread_group)
+        glGetIntegerv(GL_SM_COUNT_NV, &sms);
+    groups = sms > 0 ? unsigned(sms) * TILE_GROUPS_PER_SM : TILE_GROUPS_DEFAULT;
+    groups = std::min(groups, tiles_x * tiles_y);
+    queue.init(nullptr, 0, binding);
+    build();
+}
+
+void TileQueue::set_order(int new_order){
+    order = new_order % TILE_ORDER_COUNT;
+    build();
+}
+
+void TileQueue::build(){
+    unsigned n = 1;
+    while(n < tiles_x || n < tiles_y)
+        n *= 2;
+    struct Keyed{ unsigned key, tile; };
+    Vector<Keyed> keyed;
+    for(unsigned y = 0; y < tiles_y; ++y){
+        for(unsigned x = 0; x < tiles_x; ++x){
+            Keyed& k = keyed.grow();
+            k.tile = x | (y << 16);
+            k.key = order == TILE_ORDER_MORTON ? morton(x, y) :
+                order == TILE_ORDER_HILBERT ? hilbert(n, x, y) : y * tiles_x + x;
+        }
+    }
+    std::sort(keyed.begin(), keyed.end(), [](const Keyed& a, const Keyed& b){ return a.key < b.key; });
+
+    Vector<unsigned> data;
+    data.resize(2 + keyed.count());
+    data[0] = 0;
+    data[1] = keyed.count();
+    for(int i = 0; i < keyed.count(); ++i)
+        data[2 + i] = keyed[i].tile;
+    queue.upload(data.begin(), data.bytes());
+}
+
+void TileQueue::dispatch(ComputeShader& depth){
+    TileQueueHeader header = {0, tiles_x * tiles_y};
+    queue.update(&header, sizeof(header));
+    depth.setUniformInt("persistent", 1);
+    depth.call(groups, 1, 1);
+    depth.setUniformInt("persistent", 0);
+}
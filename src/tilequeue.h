@@ -0,0 +1,44 @@
+#ifndef TILEQUEUE_H
+#define TILEQUEUE_H
+
+#include "compute_shader.h"
+#include "SSBO.h"
+
+// pixels per side of a tile, the workgroup size of depth.glsl
+#define TILE_SIZE 8
+
+#define TILE_ORDER_SCANLINE 0
+#define TILE_ORDER_MORTON 1
+#define TILE_ORDER_HILBERT 2
+#define TILE_ORDER_COUNT 3
+
+/*
+    Persistent-threads dispatch of depth.glsl. Rather than a workgroup per
+    tile, a fixed number of workgroups sized to the device stay resident
+    and take tiles from an atomic counter until the image runs out, so
+    slow tiles of geometry do not leave the gpu idle behind them. Tiles
+    are handed out in scanline, Morton or Hilbert order.
+
+    Storage: the counter, the tile count and the tiles in order at one
+    ssbo binding.
+*/
+class TileQueue{
+    SSBO queue;
+    unsigned tiles_x, tiles_y, groups;
+    int order;
+    bool enabled;
+    void build();
+public:
+    TileQueue() : tiles_x(0), tiles_y(0), groups(0), order(TILE_ORDER_SCANLINE), enabled(false){}
+    void init(int width, int height, unsigned binding);
+    inline void toggle(){ enabled = !enabled; }
+    inline bool on()const{ return enabled; }
+    void set_order(int order);
+    inline int get_order()const{ return order; }
+    static const char* order_name(int order);
+    inline unsigned group_count()const{ return groups; }
+    // depth bound with its other uniforms set
+    void dispatch(ComputeShader& depth);
+};
+
+#endif
@@ -1,22 +1,121 @@
 #include "myglheaders.h"
 #include "timer.h"
+#include "debugmacro.h"
 #include "stdio.h"
+#include <cstring>
 
+// timestamps rather than GL_TIME_ELAPSED, which some drivers do not
+// advance for compute work
 Timer::Timer(){
-    glGenQueries(1, &id);
+    glGenQueries(2, ids);
 }
 Timer::~Timer(){
-    glDeleteQueries(1, &id);
+    glDeleteQueries(2, ids);
 }
 void Timer::begin(){
-    glBeginQuery(GL_TIME_ELAPSED, id);
+    glQueryCounter(ids[0], GL_TIMESTAMP);
 }
-int Timer::end(){
-    glEndQuery(GL_TIME_ELAPSED);
-    int ns;
-    glGetQueryObjectiv(id, GL_QUERY_RESULT, &ns);
-    return ns / 1000000;
+double Timer::end(){
+    glQueryCounter(ids[1], GL_TIMESTAMP);
+    GLuint64 t0, t1;
+    glGetQueryObjectui64v(ids[0], GL_QUERY_RESULT, &t0);
+    glGetQueryObjectui64v(ids[1], GL_QUERY_RESULT, &t1);
+    return t1 > t0 ? (t1 - t0) * 1e-6 : 0.0;
 }
 void Timer::endPrint(){
-    printf("Timer ms: %i\n", this->end());
+    printf("Timer ms: %.3f\n", this->end());
+}
+
+FrameTimers::FrameTimers() : count(0), frame(0){
+}
+
+FrameTimers::~FrameTimers(){
+    for(int i = 0; i < count; ++i){
+        glDeleteQueries(2 * TIMER_FRAMES, &scopes[i].queries[0][0]);
+    }
+}
+
+int FrameTimers::scope(const char* name){
+    if(count >= TIMER_SCOPES){
+        printf("too many timer scopes, %s is not timed\n", name);
+        return -1;
+    }
+    Scope& s = scopes[count];
+    memset(&s, 0, sizeof(Scope));
+    s.name = name;
+    glGenQueries(2 * TIMER_FRAMES, &s.queries[0][0]);    MYGLERRORMACRO
+    return count++;
+}
+
+void FrameTimers::begin(int scope){
+    if(scope < 0)
+        return;
+    Scope& s = scopes[scope];
+    const int slot = frame % TIMER_FRAMES;
+    if(s.pending[slot])
+        collect(s, slot);
+    // still waiting on the gpu from TIMER_FRAMES ago, skip this sample
+    if(s.pending[slot])
+        return;
+    glQueryCounter(s.queries[slot][0], GL_TIMESTAMP);
+    s.open = true;
+}
+
+void FrameTimers::end(int scope){
+    if(scope < 0 || !scopes[scope].open)
+        return;
+    Scope& s = scopes[scope];
+    const int slot = frame % TIMER_FRAMES;
+    glQueryCounter(s.queries[slot][1], GL_TIMESTAMP);
+    s.pending[slot] = true;
+    s.open = false;
+}
+
+void FrameTimers::collect(Scope& s, int slot){
+    GLint available = 0;
+    glGetQueryObjectiv(s.queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available)
+        return;
+    GLuint64 t0, t1;
+    glGetQueryObjectui64v(s.queries[slot][0], GL_QUERY_RESULT, &t0);
+    glGetQueryObjectui64v(s.queries[slot][1], GL_QUERY_RESULT, &t1);
+    s.history[s.next] = t1 > t0 ? t1 - t0 : 0;
+    s.next = (s.next + 1) % TIMER_HISTORY;
+    if(s.samples < TIMER_HISTORY)
+        ++s.samples;
+    s.pending[slot] = false;
+}
+
+void FrameTimers::endFrame(){
+    for(int i = 0; i < count; ++i){
+        for(int slot = 0; slot < TIMER_FRAMES; ++slot){
+            if(scopes[i].pending[slot])
+                collect(scopes[i], slot);
+        }
+    }
+    ++frame;
+}
+
+bool FrameTimers::stats(int scope, double& mean, unsigned long long& lo, unsigned long long& hi)const{
+    if(scope < 0 || !scopes[scope].samples)
+        return false;
+    const Scope& s = scopes[scope];
+    unsigned long long sum = 0;
+    lo = hi = s.history[0];
+    for(int i = 0; i < s.samples; ++i){
+        sum += s.history[i];
+        lo = s.history[i] < lo ? s.history[i] : lo;
+        hi = s.history[i] > hi ? s.history[i] : hi;
+    }
+    mean = double(sum) / s.samples;
+    return true;
+}
+
+void FrameTimers::print()const{
+    for(int i = 0; i < count; ++i){
+        double mean;
+        unsigned long long lo, hi;
+        if(stats(i, mean, lo, hi))
+            printf("  %-8s %9.3f ms, min %9.3f, max %9.3f\n", scopes[i].name, mean * 1e-6, lo * 1e-6, hi * 1e-6);
+    }
 }
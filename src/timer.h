@@ -1,14 +1,56 @@
 #ifndef TIMER_H
 #define TIMER_H
 
+// frames of queries in flight before a scope's result must be ready
+#define TIMER_FRAMES 4
+#define TIMER_SCOPES 16
+// samples kept for each scope's rolling statistics
+#define TIMER_HISTORY 64
+
+// waits for the gpu at end, only for benchmarks; use FrameTimers in frames
 class Timer{
-    unsigned id;
+    unsigned ids[2];
 public:
     Timer();
     ~Timer();
     void begin();
-    int end();
+    // milliseconds since begin
+    double end();
     void endPrint();
 };
 
+/*
+    Named gpu timing scopes without stalls. Each scope writes a pair of
+    timestamp queries into a ring of TIMER_FRAMES frames, and results are
+    only read once GL_QUERY_RESULT_AVAILABLE is set, a few frames later.
+    A scope whose ring slot is still waiting skips that frame's sample
+    rather than stall. Scopes may nest.
+*/
+class FrameTimers{
+    struct Scope{
+        const char* name;
+        unsigned queries[TIMER_FRAMES][2];
+        bool pending[TIMER_FRAMES];
+        bool open;
+        unsigned long long history[TIMER_HISTORY];  // nanoseconds
+        int samples, next;
+    };
+    Scope scopes[TIMER_SCOPES];
+    int count;
+    unsigned frame;
+    void collect(Scope& s, int slot);
+public:
+    FrameTimers();
+    ~FrameTimers();
+    // returns the handle passed to begin and end, call once per scope
+    int scope(const char* name);
+    void begin(int scope);
+    void end(int scope);
+    // reads back every finished result and moves on to the next ring slot
+    void endFrame();
+    // rolling statistics over the last TIMER_HISTORY samples, in nanoseconds
+    bool stats(int scope, double& mean, unsigned long long& lo, unsigned long long& hi)const;
+    void print()const;
+};
+
 #endif
@@ -0,0 +1,25 @@
+#ifndef UNIFORMS_H
+#define UNIFORMS_H
+
+#include "glm/glm.hpp"
+
+// defaults of Uniforms::limits
+#define PATH_BOUNCES 5
+#define PATH_STEPS 60
+#define PATH_ROULETTE_START 2
+// the most bounces the wavefront tracer dispatches for
+#define PATH_MAX_BOUNCES 8
+
+// CAM_BUF in depth.glsl
+struct Uniforms
+{
+    glm::mat4 IVP;
+    glm::vec4 eye;
+    glm::vec4 nfwh;
+    glm::vec4 seed;
+    // [bounces, march steps per ray, bounces before russian roulette, roulette on]
+    glm::ivec4 limits;
+    Uniforms() : limits(PATH_BOUNCES, PATH_STEPS, PATH_ROULETTE_START, 1){}
+};
+
+#endif
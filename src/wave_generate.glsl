@@ -0,0 +1,54 @@
+#version 430 core
+
+#define EYE eye.xyz
+#define FAR nfwh.y
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding=2) uniform CAM_BUF
+{
+    mat4 IVP;
+    vec4 eye;
+    vec4 nfwh;
+    vec4 seed;
+    ivec4 limits;   // bounces, march steps, bounces before roulette, roulette on
+};
+
+#include "scene.glsl"
+#include "accumulate.glsl"
+#include "shading.glsl"
+#include "wavefront.glsl"
+
+uniform int cone_enabled;
+layout(binding = 4, r32f) uniform readonly image2D cone_depth;
+
+// a primary ray per pixel, or per pixel of the adaptive list
+void main(){
+    ivec2 pix;
+    if(!invocation_pixel(pix))
+        return;
+    const ivec2 size = imageSize(color);
+
+    uint s;
+    const vec3 rd = primary_ray(pix, size, s);
+    float start = cone_enabled != 0 ? imageLoad(cone_depth, pix / 8).x : 0.0;
+    const uint ray = uint(pix.y * size.x + pix.x);
+    // a cached first hit leaves the march a step, and a cached stall only
+    // its last one
+    bool stalled = false;
+    const float cached = primary_cache != 0 ? primary_lookup(ray, stalled) : -1.0;
+    if(cached >= 0.0)
+        start = cached;
+    wave_rays[ray] = WaveRay(
+        vec4(EYE + rd * start, -1.0),
+        vec4(rd, -1.0),
+        vec4(0.0),
+        vec4(1.0, 1.0, 1.0, 0.0),
+        vec4(EYE, 0.0),
+        vec4(0.0, 0.0, 0.0, -1.0),
+        vec4(0.0),
+        uvec4(uint(pix.x) | (uint(pix.y) << 16), s, 0u, cached >= 0.0 && stalled ? 1u : 0u));
+    if(gbuffer_enabled != 0)
+        gbuffer[ray] = uvec2(packUnorm4x8(vec4(1.0)), 0xffffffffu);
+    wave_push(ray);
+}
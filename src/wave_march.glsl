@@ -0,0 +1,70 @@
+#version 430 core
+
+layout(local_size_x = 64) in;
+
+layout(binding=2) uniform CAM_BUF
+{
+    mat4 IVP;
+    vec4 eye;
+    vec4 nfwh;
+    vec4 seed;
+    ivec4 limits;   // bounces, march steps, bounces before roulette, roulette on
+};
+
+#include "scene.glsl"
+#include "wavefront.glsl"
+#include "primary_cache.glsl"
+
+layout(std430, binding = 8) buffer STEP_BUF
+{
+    uint primary_steps;
+    uint cone_steps;
+    uint rays;
+    uint ray_steps;
+};
+uniform int count_steps;
+
+// sphere traces each queued ray and queues the ones that hit an edit for shading
+void main(){
+    const uint i = gl_GlobalInvocationID.x;
+    if(i >= in_count)
+        return;
+    const uint ray = in_rays[i];
+    const float e = 0.001;
+    vec3 p = wave_rays[ray].origin.xyz;
+    const vec3 rd = wave_rays[ray].dir.xyz;
+    const uint bounce = wave_rays[ray].state.z;
+
+    const int budget = bounce == 0u && wave_rays[ray].state.w != 0u ? 1 : limits.y;
+    vec2 sam;
+    int j;
+    for(j = 0; j < budget; j++){
+        sam = scene_map(p);
+        if(abs(sam.x) < e){
+            break;
+        }
+        p = p + rd * sam.x;
+    }
+    if(count_steps != 0){
+        const uint steps = uint(min(j + 1, budget));
+        if(bounce == 0u)
+            atomicAdd(primary_steps, steps);
+        atomicAdd(rays, 1u);
+        atomicAdd(ray_steps, steps);
+    }
+
+    const int sdf_id = int(sam.y);
+    const bool hit = sdf_id >= 0 && sdf_id < num_sdfs;
+    wave_rays[ray].origin = vec4(p, hit ? float(sdf_id) : -1.0);
+    // rays that ran out of steps are misses to the history
+    if(bounce == 0u){
+        wave_rays[ray].state.w = j < budget ? 1u : 0u;
+        // rays are stored by pixel
+        if(primary_cache != 0 && hit && j < budget)
+            primary_store(ray, distance(p, eye.xyz), false);
+        else if(primary_cache != 0 && j == budget)
+            primary_store(ray, distance(p - rd * sam.x, eye.xyz), true);
+    }
+    if(hit)
+        wave_push(ray);
+}
@@ -0,0 +1,38 @@
+#version 430 core
+
+#define EYE eye.xyz
+#define FAR nfwh.y
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding=2) uniform CAM_BUF
+{
+    mat4 IVP;
+    vec4 eye;
+    vec4 nfwh;
+    vec4 seed;
+    ivec4 limits;   // bounces, march steps, bounces before roulette, roulette on
+};
+
+#include "scene.glsl"
+#include "accumulate.glsl"
+#include "shading.glsl"
+#include "radiance_cache.glsl"
+#include "wavefront.glsl"
+
+// adds each finished path to its radiance cache cell and blends it into the
+// history like depth.glsl
+void main(){
+    ivec2 pix;
+    if(!invocation_pixel(pix))
+        return;
+    const ivec2 size = imageSize(color);
+
+    uint s;
+    const vec3 rd = primary_ray(pix, size, s);
+    const WaveRay r = wave_rays[pix.y * size.x + pix.x];
+    if(r.cached.w >= 0.0)
+        cache_add(int(r.cached.w), cache_path_radiance(r.color.xyz, r.cached.xyz, r.cached_mask.xyz));
+    const vec4 hit = r.dir.w < 0.0 ? vec4(0.0, 0.0, 0.0, -1.0) : vec4(oct_decode(vec2(r.color.w, r.mask.w)), r.dir.w);
+    accumulate(pix, size, rd, r.color.xyz, hit);
+}
@@ -0,0 +1,112 @@
+#version 430 core
+
+#define EYE eye.xyz
+#define FAR nfwh.y
+
+layout(local_size_x = 64) in;
+
+layout(binding=2) uniform CAM_BUF
+{
+    mat4 IVP;
+    vec4 eye;
+    vec4 nfwh;
+    vec4 seed;
+    ivec4 limits;   // bounces, march steps, bounces before roulette, roulette on
+};
+
+#include "scene.glsl"
+#include "accumulate.glsl"
+#include "shading.glsl"
+#include "emitters.glsl"
+#include "lpv_volume.glsl"
+#include "radiance_cache.glsl"
+#include "wavefront.glsl"
+
+// gathers the emission of each queued ray's hit, ends the path there when
+// the radiance volume or cache has its second hit, or else picks its next
+// direction and queues it for the next march until limits.x bounces or
+// roulette stop it
+void main(){
+    const uint i = gl_GlobalInvocationID.x;
+    if(i >= in_count)
+        return;
+    const uint ray = in_rays[i];
+    const float e = 0.001;
+    WaveRay r = wave_rays[ray];
+    const int sdf_id = int(r.origin.w);
+    const bool first = r.state.z == 0u && r.state.w != 0u;
+    vec3 p = r.origin.xyz;
+    uint s = r.state.y;
+    begin_sample(ivec2(r.state.x & 0xffffu, r.state.x >> 16));
+
+    vec3 N;
+    vec2 uv;
+    {
+        mat3 TBN;
+        TBN[2] = scene_map_normal(p);
+        // past every edit there is nothing to shade, as in depth.glsl
+        if(TBN[2] == vec3(0.0)){
+            wave_rays[ray] = r;
+            return;
+        }
+        if(first){
+            const vec2 oct = oct_encode(TBN[2]);
+            r.dir.w = distance(p, EYE);
+            r.color.w = oct.x;
+            r.mask.w = oct.y;
+        }
+        TBN[0] = normalize(cross(TBN[2], normalize(vec3(0.01 * rand(s), 1.0, 0.0))));
+        TBN[1] = cross(TBN[2], TBN[0]);
+        uv = uv_from_ray(TBN[2], p) * sdf_uv_scale(sdf_id);
+        const vec4 tN = sdf_normal_texture(sdf_id, uv);
+        N = TBN * normalize(tN.xyz * 2.0 - 1.0);
+    }
+
+    const vec3 V = -r.dir.xyz;
+    p += N * e * 4.0f;
+
+    const vec4 albedo = sdf_albedo_texture(sdf_id, uv);
+    const vec4 material = sdf_material_texture(sdf_id, uv);
+
+    if(first && gbuffer_enabled != 0)
+        gbuffer[ray] = uvec2(packUnorm4x8(vec4(albedo.rgb, 1.0)), uint(sdf_object_id(sdf_id)));
+    const float emitted = r.state.z == 0u ? 1.0 : emission_weight(sdf_id, r.last.xyz, r.dir.xyz, r.last.w);
+    r.color.xyz += r.mask.xyz * albedo.rgb * albedo.a * 100.0 * emitted;
+    if(lpv_enabled != 0 && r.state.z == 1u){
+        const vec4 volume = lpv_lookup(p, N);
+        if(volume.w > 0.0){
+            r.color.xyz += r.mask.xyz * albedo.rgb * volume.rgb / 6.2831853;
+            r.state.y = s;
+            wave_rays[ray] = r;
+            return;
+        }
+    }
+    if(cache_enabled != 0 && r.state.z == 1u){
+        vec4 L;
+        const int cell = cache_visit(p, N, L);
+        if(L.w > 0.0){
+            r.color.xyz += r.mask.xyz * L.rgb;
+            r.state.y = s;
+            wave_rays[ray] = r;
+            return;
+        }
+        r.cached = vec4(r.color.xyz, float(cell));
+        r.cached_mask.xyz = r.mask.xyz;
+    }
+    if(int(r.state.z) + 1 < limits.x)
+        r.color.xyz += r.mask.xyz * sample_emitters(p, V, N, albedo.rgb, material.x, material.y, s, 2u + 2u * r.state.z);
+    vec3 weight;
+    const vec3 L = sample_brdf(V, N, albedo.rgb, material.x, material.y, s, 1u + 2u * r.state.z, weight, r.last.w);
+    r.last.xyz = p;
+    r.mask.xyz *= weight;
+    r.origin.xyz = p;
+    r.dir.xyz = L;
+    r.state.z += 1u;
+    vec3 mask = r.mask.xyz;
+    const bool alive = roulette(mask, int(r.state.z), s) && int(r.state.z) < limits.x;
+    r.mask.xyz = mask;
+    r.state.y = s;
+    wave_rays[ray] = r;
+    if(alive)
+        wave_push(ray);
+}
@@ -0,0 +1,79 @@
+#include "wavefront.h"
+#include "adaptive.h"
+#include "sdf.h"
+#include "uniforms.h"
+#include "myglheaders.h"
+
+struct WaveQueueHeader{
+    unsigned groups[3];
+    unsigned count;
+};
+
+// the size of WaveRay in wavefront.glsl
+#define WAVE_RAY_BYTES (8 * 4 * sizeof(float))
+
+static const GLbitfield wave_barrier = GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT;
+
+Wavefront::Wavefront()
+    : generate("assets/wave_generate.glsl"), resolve("assets/wave_resolve.glsl"),
+    march("assets/wave_march.glsl"), shade("assets/wave_shade.glsl"),
+    width(0), height(0), queue_binding(0), in(0), enabled(false){
+}
+
+void Wavefront::init(int w, int h, unsigned ray_binding, unsigned first_queue_binding){
+    width = w;
+    height = h;
+    queue_binding = first_queue_binding;
+    rays.init(nullptr, 0, ray_binding);
+    rays.upload(nullptr, width * height * WAVE_RAY_BYTES);
+    for(int i = 0; i < 2; ++i){
+        queues[i].init(nullptr, 0, queue_binding + i);
+        queues[i].upload(nullptr, sizeof(WaveQueueHeader) + width * height * sizeof(unsigned));
+    }
+    in = 0;
+}
+
+// the queue written so far is read next, and the other emptied for writing
+void Wavefront::swap(){
+    in ^= 1;
+    queues[in].bind(queue_binding);
+    queues[in ^ 1].bind(queue_binding + 1);
+    WaveQueueHeader header = {{0, 1, 1}, 0};
+    queues[in ^ 1].update(&header, sizeof(header));
+}
+
+void Wavefront::trace(SDF_Edits& edits, const Setup& setup, AdaptiveSampler* adaptive){
+    swap();
+    generate.bind();
+    setup(generate);
+    if(adaptive)
+        adaptive->trace(generate);
+    else
+        generate.call((width + 7) / 8, (height + 7) / 8, 1);
+    glMemoryBarrier(wave_barrier);
+
+    ComputeShader& marcher = march.select(edits);
+    ComputeShader& shader = shade.select(edits);
+    // queues emptied by the limits dispatch no groups
+    for(int i = 0; i < PATH_MAX_BOUNCES; ++i){
+        swap();
+        marcher.bind();
+        setup(marcher);
+        marcher.callIndirect(queues[in].handle());
+        glMemoryBarrier(wave_barrier);
+
+        swap();
+        shader.bind();
+        setup(shader);
+        shader.callIndirect(queues[in].handle());
+        glMemoryBarrier(wave_barrier);
+    }
+
+    resolve.bind();
+    setup(resolve);
+    if(adaptive)
+        adaptive->trace(resolve);
+    else
+        resolve.call((width + 7) / 8, (height + 7) / 8, 1);
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+}
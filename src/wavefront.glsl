@@ -0,0 +1,48 @@
+// Ray state and queues of the wavefront path tracer, see wavefront.h.
+
+// threads of the kernels driven by a queue, must match wavefront.h
+#define WAVE_GROUP 64
+
+// one per pixel, at y * width + x
+struct WaveRay {
+    vec4 origin;  // xyz: start of the next march, w: edit hit by the last march, -1 on a miss
+    vec4 dir;     // xyz: direction, w: distance of the first hit from the eye, -1 on a miss
+    vec4 color;   // xyz: radiance gathered, w: octahedral normal x of the first hit
+    vec4 mask;    // xyz: throughput, w: octahedral normal y of the first hit
+    vec4 last;    // xyz: where the last bounce left from, w: the density of its direction there
+    vec4 cached;  // xyz: radiance gathered on reaching a radiance cache cell, w: the cell, -1 when none
+    vec4 cached_mask; // xyz: throughput there
+    uvec4 state;  // x: pixel as x | y << 16, y: random state, z: bounce, w: 1 when the primary march is to take one step, then when it converged
+};
+
+layout(std430, binding = 11) buffer WAVE_RAY_BUF
+{
+    WaveRay wave_rays[];
+};
+
+// rays to process and rays for the next kernel, each led by the group
+// count of an indirect dispatch
+layout(std430, binding = 12) readonly buffer WAVE_QUEUE_IN
+{
+    uint in_groups_x;
+    uint in_groups_y;
+    uint in_groups_z;
+    uint in_count;
+    uint in_rays[];
+};
+
+layout(std430, binding = 13) buffer WAVE_QUEUE_OUT
+{
+    uint out_groups_x;
+    uint out_groups_y;
+    uint out_groups_z;
+    uint out_count;
+    uint out_rays[];
+};
+
+void wave_push(uint ray){
+    const uint i = atomicAdd(out_count, 1u);
+    out_rays[i] = ray;
+    if(i % uint(WAVE_GROUP) == 0u)
+        atomicAdd(out_groups_x, 1u);
+}
@@ -0,0 +1,51 @@
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include <functional>
+#include "compute_shader.h"
+#include "sdf_codegen.h"
+#include "SSBO.h"
+
+class SDF_Edits;
+class AdaptiveSampler;
+
+// must match wavefront.glsl
+#define WAVE_GROUP 64
+
+/*
+    Wavefront alternative to the depth.glsl megakernel, tracing the same
+    paths. wave_generate.glsl writes a primary ray per pixel into an SSBO
+    of ray state and queues it; wave_march.glsl marches the queued rays and
+    queues the hits; wave_shade.glsl gathers their emission, samples the
+    next direction and queues them again, until the bounce limit in
+    CAM_BUF or Russian roulette stops them; and
+    wave_resolve.glsl blends the finished paths into the history. The
+    marching and shading kernels only see live rays, compacted by the
+    queues, and run through indirect dispatches sized by them.
+
+    Storage: the rays at one binding, and the queue read and the queue
+    written at the next two, swapped between kernels.
+*/
+class Wavefront{
+    ComputeShader generate, resolve;
+    SDF_Programs march, shade;
+    SSBO rays, queues[2];
+    unsigned width, height, queue_binding;
+    int in;
+    bool enabled;
+    void swap();
+public:
+    // sets on a kernel every uniform depth.glsl would get
+    typedef std::function<void(ComputeShader&)> Setup;
+    Wavefront();
+    void init(int width, int height, unsigned ray_binding, unsigned queue_binding);
+    inline void toggle(){ enabled = !enabled; }
+    inline bool on()const{ return enabled; }
+    inline bool allocated()const{ return width != 0; }
+    // generated programs for the march and shade kernels, see SDF_Programs
+    inline void toggle_programs(){ march.toggle(); shade.toggle(); }
+    // one sample per pixel, or per pixel adaptive listed when set
+    void trace(SDF_Edits& edits, const Setup& setup, AdaptiveSampler* adaptive = nullptr);
+};
+
+#endif